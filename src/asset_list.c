@@ -0,0 +1,150 @@
+// asset_list.c - the startup assets per video mode, shared with xifi-bake
+#include "asset_list.h"
+#include <stdio.h>
+#include <string.h>
+
+const char* const asset_source_path[ASRC_COUNT] = {
+    "img/background.jpg", "img/DC.png", "img/TR.png", "font/font.ttf"
+};
+
+const char* const ui_menu_items[UI_MENU_ITEMS] = {
+    "Start XiFi Portal", "Clear WiFi Password", "Turn off OLED",
+    "Turn on OLED",      "Set Custom Status",   "Clear Custom Status",
+    "About"
+};
+
+const char* const ui_about_lines[UI_ABOUT_LINES] = {
+    "XiFi Config", "",
+    "Code by:", "Darkone83", "",
+    "Music By:", "Darkone83"
+};
+
+const char* asset_image_key(char* buf, const char* path, int w, int h) {
+    snprintf(buf, ASSET_KEY_MAX, "%s@%dx%d", path, w, h);
+    return buf;
+}
+
+const char* asset_text_key(char* buf, int font_px, SDL_Color col, const char* text) {
+    snprintf(buf, ASSET_KEY_MAX, "t%d/%02x%02x%02x%02x/%s", font_px, col.r, col.g, col.b, col.a, text);
+    return buf;
+}
+
+const char* asset_pack_name(char* buf, size_t len, int screen_w, int screen_h) {
+    snprintf(buf, len, "pack/%dx%d.pak", screen_w, screen_h);
+    return buf;
+}
+
+uint32_t asset_screen_format(int screen_w, int screen_h) {
+    (void)screen_w;
+    (void)screen_h;
+    return SDL_PIXELFORMAT_RGB888;
+}
+
+static uint32_t fnv(uint32_t h, const unsigned char* p, size_t n) {
+    while (n--) {
+        h ^= *p++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Adds n bytes from offset at to *h; 0 on a read error
+static int fnv_file(uint32_t* h, FILE* f, long at, long n) {
+    unsigned char buf[4096];
+    if (fseek(f, at, SEEK_SET) != 0) return 0;
+    while (n > 0) {
+        size_t want = n < (long)sizeof(buf) ? (size_t)n : sizeof(buf);
+        if (fread(buf, 1, want, f) != want) return 0;
+        *h = fnv(*h, buf, want);
+        n -= (long)want;
+    }
+    return 1;
+}
+
+uint32_t asset_source_hash(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return 0;
+    long size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    long head = size < ASSET_HASH_SPAN ? size : ASSET_HASH_SPAN;
+    long tail = size - head < ASSET_HASH_SPAN ? size - head : ASSET_HASH_SPAN;
+    uint32_t sz = (uint32_t)size;
+    uint32_t h = fnv(2166136261u, (const unsigned char*)&sz, sizeof(sz));
+    int ok = size >= 0 && fnv_file(&h, f, 0, head) && fnv_file(&h, f, size - tail, tail);
+    fclose(f);
+    if (!ok) return 0;
+    return h ? h : 1;   // 0 is reserved for "unreadable"
+}
+
+static void add_image(struct asset_item* out, int* n, int max, const char* path, int w, int h) {
+    if (*n >= max) return;
+    struct asset_item* it = &out[(*n)++];
+    memset(it, 0, sizeof(*it));
+    it->kind = ASSET_IMAGE;
+    it->src = path;
+    it->w = w;
+    it->h = h;
+    asset_image_key(it->key, path, w, h);
+}
+
+// Text drawn in several places is baked once: an existing item is returned
+// for a key the list already has, so the pack never holds a key twice
+static struct asset_item* add_text(struct asset_item* out, int* n, int max, int px,
+                                   SDL_Color col, const char* text) {
+    char key[ASSET_KEY_MAX];
+    if (!text[0]) return NULL;
+    asset_text_key(key, px, col, text);
+    for (int i = 0; i < *n; i++) {
+        if (strcmp(out[i].key, key) == 0) return &out[i];
+    }
+    if (*n >= max) return NULL;
+    struct asset_item* it = &out[(*n)++];
+    memset(it, 0, sizeof(*it));
+    it->kind = ASSET_TEXT;
+    it->src = text;
+    it->font_px = px;
+    it->col = col;
+    memcpy(it->key, key, sizeof(key));
+    return it;
+}
+
+// Must match what main.c draws: same strings, sizes and colors
+int asset_list(int screen_w, int screen_h, struct asset_item* out, int max) {
+    SDL_Color white = {255,255,255,255}, grey = {200,200,200,255}, black = {0,0,0,255};
+    SDL_Color red = {255,0,0,255}, green = {0,255,0,255};
+    int text = FONT_TEXT_PX(screen_h), logo = LOGO_PX(screen_h);
+    int n = 0;
+
+    add_image(out, &n, max, asset_source_path[ASRC_BACKGROUND], screen_w, screen_h);
+    add_image(out, &n, max, asset_source_path[ASRC_DC], logo, logo);
+    add_image(out, &n, max, asset_source_path[ASRC_TR], logo, logo);
+
+    add_text(out, &n, max, FONT_TITLE_PX(screen_h), white, "XiFi Configuration");
+    add_text(out, &n, max, text, grey, "Press ");
+    add_text(out, &n, max, text, red, "B");
+    add_text(out, &n, max, text, grey, " to exit");
+    add_text(out, &n, max, text, white, "XiFi ");
+    add_text(out, &n, max, text, green, "Detected");
+    add_text(out, &n, max, text, red, "Not Detected");
+    for (int i = 0; i < UI_MENU_ITEMS; i++) {
+        add_text(out, &n, max, text, white, ui_menu_items[i]);
+        add_text(out, &n, max, text, black, ui_menu_items[i]);
+    }
+    for (int i = 0; i < UI_ABOUT_LINES; i++) {
+        struct asset_item* it = add_text(out, &n, max, FONT_ABOUT_PX(screen_h), white, ui_about_lines[i]);
+        if (it) it->about_lines |= 1u << i;
+    }
+    return n;
+}
+
+uint32_t asset_list_hash(const struct asset_item* items, int n) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < n; i++) {
+        for (const char* p = items[i].key; *p; p++) {
+            h ^= (unsigned char)*p;
+            h *= 16777619u;
+        }
+        h ^= 0xFF;   // separator, so "ab"+"c" and "a"+"bc" differ
+        h *= 16777619u;
+    }
+    return h;
+}
@@ -0,0 +1,97 @@
+#ifndef ASSET_LIST_H
+#define ASSET_LIST_H
+
+#include <SDL.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// What the UI loads at startup for one video mode, and the on-disk format
+// of the pre-baked asset pack holding it. Shared by the app and the
+// xifi-bake host tool so both agree on every key.
+
+// --- Pack file: header, entry table, then pixel data ---
+#define ASSET_PACK_MAGIC   0x4B504658u     // "XFPK"
+#define ASSET_PACK_VERSION 3
+#define ASSET_KEY_MAX      64
+#define ASSET_ALIGN        16              // every pixel block starts aligned
+
+// Source files a pack is baked from; a hash of each is recorded so an
+// edited file makes the pack stale
+enum asset_source { ASRC_BACKGROUND, ASRC_DC, ASRC_TR, ASRC_FONT, ASRC_COUNT };
+extern const char* const asset_source_path[ASRC_COUNT];   // relative to the media root
+
+struct asset_pack_header {
+    uint32_t magic, version;
+    uint32_t width, height;                // video mode
+    uint32_t list_hash;                    // asset_list_hash() when baked
+    uint32_t screen_format;                // asset_screen_format(): the background's
+    uint32_t source_hash[ASRC_COUNT];      // asset_source_hash() of each
+    uint32_t count;                        // entries after the header
+    uint32_t file_size;
+};
+
+struct asset_pack_entry {
+    char key[ASSET_KEY_MAX];
+    uint32_t offset, size;                 // pixel block, from the start of the file
+    uint32_t w, h, pitch;
+    uint32_t format;                       // SDL_PixelFormatEnum
+};
+
+// --- Static UI text and font sizes ---
+#define FONT_TITLE_PX(h) ((h) / 15)
+#define FONT_TEXT_PX(h)  ((h) / 30)
+#define FONT_ABOUT_PX(h) ((h) / 25)
+#define LOGO_PX(h)       ((int)(64.0f * (h) / 720.0f))
+
+#define UI_MENU_ITEMS  7
+#define UI_ABOUT_LINES 7
+extern const char* const ui_menu_items[UI_MENU_ITEMS];
+extern const char* const ui_about_lines[UI_ABOUT_LINES];   // "" = blank line
+
+// --- Everything baked for one mode ---
+enum asset_kind { ASSET_IMAGE, ASSET_TEXT };
+
+struct asset_item {
+    enum asset_kind kind;
+    const char* src;          // image: media path; text: the string
+    int w, h;                 // image: size it is drawn at
+    int font_px;              // text
+    SDL_Color col;            // text
+    uint32_t about_lines;     // text: bit i set = drawn as ui_about_lines[i]
+    char key[ASSET_KEY_MAX];
+};
+
+#define ASSET_LIST_MAX 48
+
+// Fills out with the assets for a screen_w x screen_h mode; returns the count
+int asset_list(int screen_w, int screen_h, struct asset_item* out, int max);
+
+// FNV-1a over every key, so a pack baked from another list is rejected
+uint32_t asset_list_hash(const struct asset_item* items, int n);
+
+// Keys: "img/DC.png@53x53", "t24/ffffffff/About"
+const char* asset_image_key(char* buf, const char* path, int w, int h);
+const char* asset_text_key(char* buf, int font_px, SDL_Color col, const char* text);
+
+// Pixel format of the Xbox framebuffer in a video mode. platform_nxdk.c sets
+// every mode at 32 bpp, which SDL presents as XRGB8888 (SDL_PIXELFORMAT_RGB888).
+// The background is baked in it so the app uploads and copies it as is.
+uint32_t asset_screen_format(int screen_w, int screen_h);
+
+// FNV-1a over a file's size and its first and last ASSET_HASH_SPAN bytes:
+// catches edits to headers, trailers and size without reading whole images
+// off the DVD. 0 if the file can't be read.
+#define ASSET_HASH_SPAN (64 * 1024)
+uint32_t asset_source_hash(const char* path);
+
+// Pack file for a mode, relative to the media root
+const char* asset_pack_name(char* buf, size_t len, int screen_w, int screen_h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ASSET_LIST_H
@@ -0,0 +1,85 @@
+// asset_pack.c - loads the pre-baked asset pack for the current video mode
+#include "asset_pack.h"
+#include "asset_list.h"
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned char* pack = NULL;
+static const struct asset_pack_header* hdr = NULL;
+static const struct asset_pack_entry* entries = NULL;
+
+static bool reject(const char* path, const char* why) {
+    plat_log("Asset pack %s %s, loading media files\n", path, why);
+    asset_pack_close();
+    return false;
+}
+
+bool asset_pack_open(int screen_w, int screen_h) {
+    char name[32], path[256];
+    plat_asset_path(asset_pack_name(name, sizeof(name), screen_w, screen_h), path, sizeof(path));
+    asset_pack_close();
+
+    // The whole file in one read: a few large sequential reads are what
+    // the DVD drive is good at
+    FILE* f = fopen(path, "rb");
+    if (!f) return reject(path, "not found");
+    long size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    if (size < (long)sizeof(struct asset_pack_header) || fseek(f, 0, SEEK_SET) != 0) {
+        fclose(f);
+        return reject(path, "is unreadable");
+    }
+    pack = malloc((size_t)size);
+    size_t got = pack ? fread(pack, 1, (size_t)size, f) : 0;
+    fclose(f);
+    if (got != (size_t)size) return reject(path, "is unreadable");
+
+    hdr = (const struct asset_pack_header*)pack;
+    entries = (const struct asset_pack_entry*)(hdr + 1);
+    if (hdr->magic != ASSET_PACK_MAGIC || hdr->version != ASSET_PACK_VERSION ||
+        hdr->file_size != (uint32_t)size ||
+        hdr->count > (size - sizeof(*hdr)) / sizeof(*entries))
+        return reject(path, "is damaged or from another version");
+    for (uint32_t i = 0; i < hdr->count; i++) {
+        const struct asset_pack_entry* e = &entries[i];
+        if (e->offset > (uint32_t)size || e->size > (uint32_t)size - e->offset ||
+            (uint64_t)e->pitch * e->h > e->size || e->key[ASSET_KEY_MAX - 1] ||
+            e->pitch < e->w * SDL_BYTESPERPIXEL(e->format))
+            return reject(path, "is damaged");
+    }
+    if (hdr->width != (uint32_t)screen_w || hdr->height != (uint32_t)screen_h)
+        return reject(path, "is for another video mode");
+
+    // Stale: baked for a different asset list, or the sources have changed
+    // since (size plus the first and last 64 KB; decoding them is the cost
+    // being avoided, reading a little of each is not)
+    struct asset_item items[ASSET_LIST_MAX];
+    int n = asset_list(screen_w, screen_h, items, ASSET_LIST_MAX);
+    if (hdr->list_hash != asset_list_hash(items, n)) return reject(path, "is stale (asset list)");
+    for (int s = 0; s < ASRC_COUNT; s++) {
+        char src[256];
+        if (asset_source_hash(plat_asset_path(asset_source_path[s], src, sizeof(src))) != hdr->source_hash[s])
+            return reject(path, "is stale (source files changed)");
+    }
+    return true;
+}
+
+SDL_Surface* asset_pack_surface(const char* key) {
+    if (!pack) return NULL;
+    for (uint32_t i = 0; i < hdr->count; i++) {
+        const struct asset_pack_entry* e = &entries[i];
+        if (strcmp(e->key, key) == 0)
+            return SDL_CreateRGBSurfaceWithFormatFrom(pack + e->offset, (int)e->w, (int)e->h,
+                                                      SDL_BITSPERPIXEL(e->format), (int)e->pitch,
+                                                      e->format);
+    }
+    return NULL;
+}
+
+void asset_pack_close(void) {
+    free(pack);
+    pack = NULL;
+    hdr = NULL;
+    entries = NULL;
+}
@@ -0,0 +1,32 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <SDL.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pre-baked startup assets for the current video mode (see asset_list.h and
+// tools/xifi_bake.c): already decoded, scaled and rendered, so startup
+// skips JPEG/PNG decoding and text rasterization.
+
+// Reads the pack for this mode with one sequential read. Returns false,
+// logging why, if it is missing, damaged or stale (baked for another asset
+// list or from different source files); callers then load the media files.
+bool asset_pack_open(int screen_w, int screen_h);
+
+// Surface for key, pointing into the pack data (valid until
+// asset_pack_close; the caller frees the surface). NULL if the pack is not
+// open or has no such key.
+SDL_Surface* asset_pack_surface(const char* key);
+
+// Frees the pack data
+void asset_pack_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ASSET_PACK_H
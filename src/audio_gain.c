@@ -0,0 +1,134 @@
+// audio_gain.c - saturating fixed-point volume kernels (SSE2 / MMX / scalar)
+#include "audio_gain.h"
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__MMX__)
+#include <mmintrin.h>
+#endif
+#ifdef XIFI_BENCH
+#include "platform.h"
+#include <SDL.h>
+#endif
+
+#define GAIN_ROUND (1 << (GAIN_SHIFT - 1))
+
+void gain_apply_scalar(int16_t* s, int count, int gain) {
+    for (int i = 0; i < count; i++) {
+        int32_t v = ((int32_t)s[i] * gain + GAIN_ROUND) >> GAIN_SHIFT;
+        s[i] = (int16_t)(v < -32768 ? -32768 : v > 32767 ? 32767 : v);
+    }
+}
+
+// Each SIMD step widens s*gain to 32 bits from the low and high halves of
+// the 16x16 product, rounds, shifts and packs back with signed saturation
+#if defined(__SSE2__)
+static int apply_simd(int16_t* s, int count, int gain) {
+    __m128i g = _mm_set1_epi16((short)gain), rnd = _mm_set1_epi32(GAIN_ROUND);
+    int n = count & ~7;
+    for (int i = 0; i < n; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i lo = _mm_mullo_epi16(x, g), hi = _mm_mulhi_epi16(x, g);
+        __m128i a = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), rnd), GAIN_SHIFT);
+        __m128i b = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), rnd), GAIN_SHIFT);
+        _mm_storeu_si128((__m128i*)(s + i), _mm_packs_epi32(a, b));
+    }
+    return n;
+}
+#elif defined(__MMX__)
+// The Xbox's Pentium III has MMX and SSE but not SSE2, so integer SIMD is
+// 64 bits wide
+static int apply_simd(int16_t* s, int count, int gain) {
+    __m64 g = _mm_set1_pi16((short)gain), rnd = _mm_set1_pi32(GAIN_ROUND);
+    int n = count & ~3;
+    for (int i = 0; i < n; i += 4) {
+        __m64 x;
+        memcpy(&x, s + i, sizeof(x));
+        __m64 lo = _mm_mullo_pi16(x, g), hi = _mm_mulhi_pi16(x, g);
+        __m64 a = _mm_srai_pi32(_mm_add_pi32(_mm_unpacklo_pi16(lo, hi), rnd), GAIN_SHIFT);
+        __m64 b = _mm_srai_pi32(_mm_add_pi32(_mm_unpackhi_pi16(lo, hi), rnd), GAIN_SHIFT);
+        x = _mm_packs_pi32(a, b);
+        memcpy(s + i, &x, sizeof(x));
+    }
+    _mm_empty();   // hand the x87 registers back to float code
+    return n;
+}
+#else
+static int apply_simd(int16_t* s, int count, int gain) {
+    (void)s; (void)count; (void)gain;
+    return 0;
+}
+#endif
+
+void gain_apply(int16_t* s, int count, int gain) {
+    if (gain == GAIN_ONE) return;
+    if (gain <= 0) {
+        memset(s, 0, (size_t)count * sizeof(*s));
+        return;
+    }
+    int done = apply_simd(s, count, gain);
+    gain_apply_scalar(s + done, count - done, gain);
+}
+
+void gain_ramp_apply(struct gain_ramp* r, int16_t* s, int count) {
+    while (count > 0 && r->cur != r->target) {
+        int n = count < GAIN_RAMP_SEG ? count : GAIN_RAMP_SEG;
+        if (r->cur < r->target) r->cur = r->cur + GAIN_RAMP_STEP < r->target ? r->cur + GAIN_RAMP_STEP : r->target;
+        else r->cur = r->cur - GAIN_RAMP_STEP > r->target ? r->cur - GAIN_RAMP_STEP : r->target;
+        gain_apply(s, n, r->cur);
+        s += n;
+        count -= n;
+    }
+    if (count > 0) gain_apply(s, count, r->cur);
+}
+
+#ifdef XIFI_BENCH
+// The callback's previous per-sample float loop, kept for comparison
+static void bench_float(int16_t* s, int count, float volume) {
+    for (int i = 0; i < count; i++) {
+        float v = s[i] * volume;
+        if (v < -32768.f) v = -32768.f;
+        else if (v > 32767.f) v = 32767.f;
+        s[i] = (int16_t)v;
+    }
+}
+
+void gain_bench(int iterations) {
+    enum { COUNT = 2048 };   // one 1024-frame stereo callback
+    static int16_t src[COUNT], buf[COUNT], ref[COUNT];
+    uint32_t seed = 1;
+    for (int i = 0; i < COUNT; i++) {
+        seed = seed * 1103515245u + 12345u;
+        src[i] = (int16_t)(seed >> 16);
+    }
+    const int gain = GAIN_ONE * 3 / 10;
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 ticks[3];
+    for (int path = 0; path < 3; path++) {
+        Uint64 t0 = SDL_GetPerformanceCounter();
+        for (int i = 0; i < iterations; i++) {
+            memcpy(buf, src, sizeof(buf));
+            if (path == 0) bench_float(buf, COUNT, 0.3f);
+            else if (path == 1) gain_apply_scalar(buf, COUNT, gain);
+            else gain_apply(buf, COUNT, gain);
+        }
+        ticks[path] = SDL_GetPerformanceCounter() - t0;
+    }
+
+    // The kernels must agree exactly, including at full scale
+    int mismatched = 0;
+    for (int g = 0; g <= GAIN_MAX; g += 1023) {
+        memcpy(buf, src, sizeof(buf));
+        memcpy(ref, src, sizeof(ref));
+        gain_apply(buf, COUNT, g);
+        if (g != GAIN_ONE) gain_apply_scalar(ref, COUNT, g > 0 ? g : 0);
+        mismatched += memcmp(buf, ref, sizeof(buf)) != 0;
+    }
+
+    plat_log("gain bench (%d x %d samples, copy included):\n", iterations, COUNT);
+    plat_log("  float:  %u ns/callback\n", (unsigned)(ticks[0] * 1000000000 / freq / iterations));
+    plat_log("  scalar: %u ns/callback\n", (unsigned)(ticks[1] * 1000000000 / freq / iterations));
+    plat_log("  simd:   %u ns/callback%s\n", (unsigned)(ticks[2] * 1000000000 / freq / iterations),
+             mismatched ? " (MISMATCH vs scalar)" : "");
+}
+#endif
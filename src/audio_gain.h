@@ -0,0 +1,42 @@
+#ifndef AUDIO_GAIN_H
+#define AUDIO_GAIN_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fixed-point volume for 16-bit PCM. Gains are Q14 (GAIN_ONE = 1.0, up to
+// just under 2.0); results round to nearest and saturate to int16. Uses
+// SSE2 (8 samples) or MMX (4 samples) when the target has them, with a
+// scalar loop for the rest; every path gives bit-identical output.
+#define GAIN_SHIFT 14
+#define GAIN_ONE   (1 << GAIN_SHIFT)
+#define GAIN_MAX   32767
+
+void gain_apply(int16_t* s, int count, int gain);
+void gain_apply_scalar(int16_t* s, int count, int gain);
+
+// Gain that glides to a new target instead of jumping (a jump clicks).
+// Moves GAIN_RAMP_STEP per GAIN_RAMP_SEG samples: silence to full in about
+// 46 ms of 44.1 kHz stereo.
+#define GAIN_RAMP_SEG   64
+#define GAIN_RAMP_STEP  256
+
+struct gain_ramp {
+    int cur, target;
+};
+
+void gain_ramp_apply(struct gain_ramp* r, int16_t* s, int count);
+
+#ifdef XIFI_BENCH
+// Times the old float loop against the scalar and SIMD fixed-point kernels
+void gain_bench(int iterations);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_GAIN_H
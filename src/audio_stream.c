@@ -0,0 +1,243 @@
+// audio_stream.c - background music: decoder thread -> SPSC ring -> audio callback
+#include "audio_stream.h"
+#include "audio_gain.h"
+#include "platform.h"
+#include "spsc.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK_FRAMES   1024     // ring item: 1024 frames (~23 ms at 44.1 kHz)
+#define READ_BLOCKS    8        // blocks per fread, so the drive sees few large reads
+
+// --- Decoder side: the file and the staging buffer it reads into ---
+static FILE* file = NULL;
+static long data_start = 0;
+static uint32_t data_size = 0, data_left = 0;
+static unsigned char* stage = NULL;
+static int stage_pos = 0, stage_n = 0;        // in blocks
+static uint32_t refill_ms = 0;
+
+// --- Shared: the ring and counters ---
+static struct spsc_ring ring;
+static unsigned char* ring_items = NULL;
+static int frame_bytes = 4, block_bytes = 0, rate = 44100;
+static SDL_atomic_t underruns, silent_frames, slowest_read_us;
+static SDL_atomic_t gain_target;             // Q14, set by the UI
+
+// --- Audio callback side: the block being played out ---
+static unsigned char* cur = NULL;
+static int cur_pos = 0, cur_len = 0;
+static struct gain_ramp gain;
+
+static SDL_Thread* decoder = NULL;
+static volatile int decoder_running = 0;
+static int device_open = 0;
+
+static uint16_t le16(const unsigned char* p) { return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t le32(const unsigned char* p) { return le16(p) | (uint32_t)le16(p + 2) << 16; }
+
+// Walk the RIFF chunks to "fmt " and "data"; leaves the file at the samples
+static bool OpenWav(const char* path, int* channels) {
+    file = fopen(path, "rb");
+    if (!file) return false;
+    unsigned char h[16];
+    if (fread(h, 1, 12, file) != 12 || memcmp(h, "RIFF", 4) || memcmp(h + 8, "WAVE", 4)) return false;
+    bool have_fmt = false;
+    int format = 0, bits = 0;
+    for (;;) {
+        if (fread(h, 1, 8, file) != 8) return false;
+        uint32_t size = le32(h + 4);
+        if (!memcmp(h, "data", 4)) break;
+        if (!memcmp(h, "fmt ", 4) && size >= 16) {
+            if (fread(h, 1, 16, file) != 16) return false;
+            format = le16(h);
+            *channels = le16(h + 2);
+            rate = (int)le32(h + 4);
+            bits = le16(h + 14);
+            have_fmt = true;
+            size -= 16;
+        }
+        if (fseek(file, (long)(size + (size & 1)), SEEK_CUR) != 0) return false;
+    }
+    data_start = ftell(file);
+    data_size = le32(h + 4) / (uint32_t)(*channels * 2) * (uint32_t)(*channels * 2);
+    data_left = data_size;
+    return have_fmt && format == 1 && bits == 16 && *channels >= 1 && *channels <= 2 &&
+           rate > 0 && data_size > 0;
+}
+
+// Read the next READ_BLOCKS blocks, looping back to the first sample at the end
+static bool ReadStage(void) {
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    size_t want = (size_t)block_bytes * READ_BLOCKS, got = 0;
+    while (got < want) {
+        if (data_left == 0) {
+            if (fseek(file, data_start, SEEK_SET) != 0) return false;
+            data_left = data_size;
+        }
+        size_t n = want - got < data_left ? want - got : data_left;
+        size_t r = fread(stage + got, 1, n, file);
+        if (r == 0) {
+            if (data_left == data_size) return false;   // nothing to play at all
+            data_left = 0;                              // header overstated the size
+            continue;
+        }
+        got += r;
+        data_left -= (uint32_t)r;
+    }
+    uint32_t us = (uint32_t)((SDL_GetPerformanceCounter() - t0) * 1000000 / SDL_GetPerformanceFrequency());
+    if (us > (uint32_t)SDL_AtomicGet(&slowest_read_us)) SDL_AtomicSet(&slowest_read_us, (int)us);
+    stage_pos = 0;
+    stage_n = READ_BLOCKS;
+    return true;
+}
+
+// Push blocks until the ring is full. False on a read error.
+static bool Fill(void) {
+    for (;;) {
+        if (stage_pos == stage_n && !ReadStage()) return false;
+        if (!spsc_push(&ring, stage + (size_t)stage_pos * block_bytes)) return true;
+        stage_pos++;
+    }
+}
+
+static int DecoderThread(void* arg) {
+    (void)arg;
+    while (decoder_running) {
+        if (!Fill()) {
+            plat_log("Audio: read error, music stopped\n");
+            break;
+        }
+        SDL_Delay(refill_ms);
+    }
+    return 0;
+}
+
+// Real-time audio thread: copy decoded blocks out, never touch the file
+static void AudioCallback(void* userdata, Uint8* stream, int len) {
+    (void)userdata;
+    int done = 0;
+    while (done < len) {
+        if (cur_pos == cur_len) {
+            if (!spsc_pop(&ring, cur)) break;
+            cur_pos = 0;
+            cur_len = block_bytes;
+        }
+        int n = len - done < cur_len - cur_pos ? len - done : cur_len - cur_pos;
+        memcpy(stream + done, cur + cur_pos, n);
+        cur_pos += n;
+        done += n;
+    }
+    if (done < len) {
+        SDL_memset(stream + done, 0, len - done);
+        SDL_AtomicAdd(&underruns, 1);
+        SDL_AtomicAdd(&silent_frames, (len - done) / frame_bytes);
+    }
+    gain.target = SDL_AtomicGet(&gain_target);
+    gain_ramp_apply(&gain, (int16_t*)stream, done / (int)sizeof(int16_t));
+}
+
+static int PercentToGain(int pct) {
+    if (pct < 0) pct = 0;
+    if (pct > AUDIO_VOLUME_MAX) pct = AUDIO_VOLUME_MAX;
+    return pct * GAIN_ONE / 100;
+}
+
+void AudioStream_SetVolume(int percent) {
+    SDL_AtomicSet(&gain_target, PercentToGain(percent));
+}
+
+int AudioStream_GetVolume(void) {
+    return (SDL_AtomicGet(&gain_target) * 100 + GAIN_ONE / 2) / GAIN_ONE;
+}
+
+bool AudioStream_Start(const char* path, int device_samples, int ahead_ms, int volume) {
+    int channels = 2;
+    if (decoder_running) return true;
+    if (!OpenWav(path, &channels)) {
+        plat_log("Audio: %s is not a 16-bit PCM WAV\n", path);
+        AudioStream_Stop();
+        return false;
+    }
+    frame_bytes = channels * 2;
+    block_bytes = BLOCK_FRAMES * frame_bytes;
+    gain.cur = gain.target = PercentToGain(volume);
+    SDL_AtomicSet(&gain_target, gain.cur);
+
+    // Ring: at least ahead_ms of blocks, rounded up to a power of two
+    unsigned want = (unsigned)(((int64_t)ahead_ms * rate / 1000 + BLOCK_FRAMES - 1) / BLOCK_FRAMES);
+    unsigned cap = 2;
+    while (cap < want) cap <<= 1;
+    ring_items = malloc((size_t)cap * block_bytes);
+    stage = malloc((size_t)READ_BLOCKS * block_bytes);
+    cur = malloc(block_bytes);
+    if (!ring_items || !stage || !cur) {
+        AudioStream_Stop();
+        return false;
+    }
+    spsc_init(&ring, ring_items, cap, block_bytes);
+    stage_pos = stage_n = cur_pos = cur_len = 0;
+    SDL_AtomicSet(&underruns, 0);
+    SDL_AtomicSet(&silent_frames, 0);
+    SDL_AtomicSet(&slowest_read_us, 0);
+
+    // Top up a quarter of the ring at a time: long sleeps, but a stall still
+    // has three quarters of the buffer to play from
+    refill_ms = (uint32_t)((uint64_t)cap * BLOCK_FRAMES * 1000 / rate / 4);
+    if (refill_ms < 5) refill_ms = 5;
+
+    // Prefill here so playback starts from a full ring
+    if (!Fill()) {
+        AudioStream_Stop();
+        return false;
+    }
+
+    SDL_AudioSpec spec = {0};
+    spec.freq     = rate;
+    spec.format   = AUDIO_S16LSB;
+    spec.channels = (Uint8)channels;
+    spec.samples  = (Uint16)device_samples;
+    spec.callback = AudioCallback;
+    if (SDL_OpenAudio(&spec, NULL) < 0) {
+        AudioStream_Stop();
+        return false;
+    }
+    device_open = 1;
+
+    decoder_running = 1;
+    decoder = SDL_CreateThread(DecoderThread, "XiFiAudio", NULL);
+    if (!decoder) {
+        decoder_running = 0;
+        AudioStream_Stop();
+        return false;
+    }
+    SDL_PauseAudio(0);
+    return true;
+}
+
+void AudioStream_Stop(void) {
+    if (device_open) SDL_CloseAudio();   // waits for a running callback
+    device_open = 0;
+    if (decoder) {
+        decoder_running = 0;
+        SDL_WaitThread(decoder, NULL);
+        decoder = NULL;
+    }
+    if (file) fclose(file);
+    file = NULL;
+    free(ring_items);
+    free(stage);
+    free(cur);
+    ring_items = stage = cur = NULL;
+}
+
+void AudioStream_GetStats(struct audio_stats* out) {
+    unsigned queued = (unsigned)SDL_AtomicGet(&ring.head) - (unsigned)SDL_AtomicGet(&ring.tail);
+    out->underruns = (uint32_t)SDL_AtomicGet(&underruns);
+    out->silent_frames = (uint32_t)SDL_AtomicGet(&silent_frames);
+    out->buffered_ms = ring_items ? (uint32_t)((uint64_t)queued * BLOCK_FRAMES * 1000 / rate) : 0;
+    out->capacity_ms = ring_items ? (uint32_t)((uint64_t)ring.cap * BLOCK_FRAMES * 1000 / rate) : 0;
+    out->slowest_read_us = (uint32_t)SDL_AtomicGet(&slowest_read_us);
+}
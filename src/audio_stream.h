@@ -0,0 +1,43 @@
+#ifndef AUDIO_STREAM_H
+#define AUDIO_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Background music. A decoder thread streams a looping 16-bit PCM WAV ahead
+// into a lock-free ring; the SDL audio callback only copies blocks out and
+// scales them, so a stalled DVD or HDD read never blocks the audio thread.
+
+// Open the WAV at path, prefill the ring, start the decoder thread and the
+// audio device. device_samples is the SDL buffer size in frames, ahead_ms
+// how much decoded audio to keep queued. Returns false if the file is not
+// 16-bit PCM or the device can't be opened. volume is in percent.
+bool AudioStream_Start(const char* path, int device_samples, int ahead_ms, int volume);
+
+// Stop playback and the decoder, close the file
+void AudioStream_Stop(void);
+
+// Music volume in percent, 0..AUDIO_VOLUME_MAX. Changes ramp in over a few
+// tens of milliseconds; safe from any thread.
+#define AUDIO_VOLUME_MAX 100
+void AudioStream_SetVolume(int percent);
+int AudioStream_GetVolume(void);
+
+struct audio_stats {
+    uint32_t underruns;        // callbacks that ran out of decoded audio
+    uint32_t silent_frames;    // frames played as silence because of them
+    uint32_t buffered_ms;      // decoded audio waiting in the ring
+    uint32_t capacity_ms;      // ring size
+    uint32_t slowest_read_us;  // longest single file read by the decoder
+};
+void AudioStream_GetStats(struct audio_stats* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_STREAM_H
@@ -0,0 +1,148 @@
+// boot_load.c - startup assets: loader thread -> SPSC ring -> render thread
+#include "boot_load.h"
+#include "asset_pack.h"
+#include "font_cache.h"
+#include "img_scale.h"
+#include "platform.h"
+#include "spsc.h"
+#include <SDL_image.h>
+
+#define MSG_CAP 64     // room for every asset plus BOOT_FONTS and BOOT_DONE
+
+static struct asset_item items[ASSET_LIST_MAX];
+static int n_items = 0;
+static int screen_w = 0, screen_h = 0;
+static Uint32 screen_format = 0;
+
+static struct spsc_ring ring;
+static struct boot_msg msgs[MSG_CAP];
+
+static struct boot_fonts fonts;
+static bool used_pack = false;
+static uint32_t load_ms = 0;
+
+static SDL_Thread* loader = NULL;
+static volatile int loader_running = 0;
+static bool started = false;     // until BootLoad_Stop, thread or not
+
+// The ring holds every message the loader can send, so this never fails
+static void Post(enum boot_msg_kind kind, int index, SDL_Surface* surf) {
+    struct boot_msg m = { kind, index, surf };
+    if (!spsc_push(&ring, &m) && surf) SDL_FreeSurface(surf);
+}
+
+static TTF_Font* FontFor(int px) {
+    if (px == FONT_TITLE_PX(screen_h)) return fonts.title;
+    if (px == FONT_TEXT_PX(screen_h)) return fonts.text;
+    if (px == FONT_ABOUT_PX(screen_h)) return fonts.about;
+    return NULL;
+}
+
+// From the pack if it has it, else decoded/rendered the slow way
+static SDL_Surface* LoadAsset(const struct asset_item* it) {
+    bool bg = it->kind == ASSET_IMAGE && it->src == asset_source_path[ASRC_BACKGROUND];
+    SDL_Surface* s = used_pack ? asset_pack_surface(it->key) : NULL;
+    if (s && bg && s->format->format != screen_format) {
+        // Baked for asset_screen_format(), which this window doesn't match
+        plat_log("Loader: pack background is %s, window is %s; converting\n",
+                 SDL_GetPixelFormatName(s->format->format), SDL_GetPixelFormatName(screen_format));
+    }
+    if (!s && it->kind == ASSET_IMAGE) {
+        char path[256];
+        SDL_Surface* raw = IMG_Load(plat_asset_path(it->src, path, sizeof(path)));
+        if (raw) {
+            s = img_scale(raw, it->w, it->h, bg ? screen_format : SDL_PIXELFORMAT_ARGB8888);
+            SDL_FreeSurface(raw);
+        }
+    } else if (!s) {
+        TTF_Font* font = FontFor(it->font_px);
+        if (font) s = TTF_RenderText_Blended(font, it->src, it->col);
+    }
+    // The background is copied 1:1 every frame, so match the window
+    if (s && bg && s->format->format != screen_format) {
+        SDL_Surface* conv = SDL_ConvertSurfaceFormat(s, screen_format, 0);
+        SDL_FreeSurface(s);
+        s = conv;
+    }
+    return s;
+}
+
+static int LoaderThread(void* arg) {
+    (void)arg;
+    uint32_t t0 = SDL_GetTicks();
+    used_pack = asset_pack_open(screen_w, screen_h);
+    uint32_t t_pack = SDL_GetTicks();
+
+    // One read of the font file; the three sizes share it
+    char path[256];
+    font_cache_load(plat_asset_path(asset_source_path[ASRC_FONT], path, sizeof(path)));
+    fonts.title = font_cache_open(FONT_TITLE_PX(screen_h));
+    fonts.text  = font_cache_open(FONT_TEXT_PX(screen_h));
+    fonts.about = font_cache_open(FONT_ABOUT_PX(screen_h));
+    Post(BOOT_FONTS, -1, NULL);
+    uint32_t t_fonts = SDL_GetTicks();
+
+    for (int i = 0; i < n_items && loader_running; i++) {
+        SDL_Surface* s = LoadAsset(&items[i]);
+        if (s) Post(BOOT_ASSET, i, s);
+        else plat_log("Could not load %s: %s\n", items[i].key, SDL_GetError());
+    }
+    font_cache_prepare(fonts.text);   // glyphs for the runtime text
+    if (!loader_running) return 0;
+    load_ms = SDL_GetTicks() - t0;
+    plat_log("Loader: pack %u ms, fonts %u ms, assets %u ms (%s)\n",
+             (unsigned)(t_pack - t0), (unsigned)(t_fonts - t_pack),
+             (unsigned)(SDL_GetTicks() - t_fonts), used_pack ? "asset pack" : "media files");
+    Post(BOOT_DONE, -1, NULL);
+    return 0;
+}
+
+void BootLoad_Start(int w, int h, Uint32 format) {
+    screen_w = w;
+    screen_h = h;
+    screen_format = format;
+    n_items = asset_list(w, h, items, ASSET_LIST_MAX);
+    spsc_init(&ring, msgs, MSG_CAP, sizeof(msgs[0]));
+    SDL_memset(&fonts, 0, sizeof(fonts));
+    loader_running = 1;
+    started = true;
+    loader = SDL_CreateThread(LoaderThread, "XiFiLoad", NULL);
+    if (!loader) {
+        // No splash time, but the same results: the ring holds them all
+        plat_log("Could not start the loader thread (%s), loading here\n", SDL_GetError());
+        LoaderThread(NULL);
+    }
+}
+
+bool BootLoad_Poll(struct boot_msg* out) {
+    return spsc_pop(&ring, out) != 0;
+}
+
+const struct asset_item* BootLoad_Asset(int index) {
+    return &items[index];
+}
+
+void BootLoad_Fonts(struct boot_fonts* out) {
+    *out = fonts;
+}
+
+bool BootLoad_UsedPack(void) {
+    return used_pack;
+}
+
+uint32_t BootLoad_Millis(void) {
+    return load_ms;
+}
+
+void BootLoad_Stop(void) {
+    if (!started) return;
+    started = false;
+    loader_running = 0;
+    if (loader) SDL_WaitThread(loader, NULL);
+    loader = NULL;
+    struct boot_msg m;
+    while (spsc_pop(&ring, &m)) {
+        if (m.surf) SDL_FreeSurface(m.surf);
+    }
+    asset_pack_close();   // after the last pack surface is gone
+}
@@ -0,0 +1,68 @@
+#ifndef BOOT_LOAD_H
+#define BOOT_LOAD_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <stdbool.h>
+#include "asset_list.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Startup assets off the render thread. A loader thread reads the asset
+// pack (or decodes the media files), opens the fonts and produces every
+// asset_list() entry as an SDL_Surface; the render thread polls the results
+// and turns them into textures, so the splash and then the menu draw while
+// loading is still going on.
+
+enum boot_msg_kind {
+    BOOT_ASSET,    // surf holds asset index, ready to upload
+    BOOT_FONTS,    // fonts are open (the loader still renders with them)
+    BOOT_DONE,     // every asset sent; the fonts are free to render with
+};
+
+struct boot_msg {
+    enum boot_msg_kind kind;
+    int index;             // BOOT_ASSET: into BootLoad_Asset()
+    SDL_Surface* surf;     // BOOT_ASSET: the caller frees it after uploading
+};
+
+struct boot_fonts {
+    TTF_Font* title;       // FONT_TITLE_PX
+    TTF_Font* text;        // FONT_TEXT_PX
+    TTF_Font* about;       // FONT_ABOUT_PX
+};
+
+// Start loading for a screen_w x screen_h mode. The background comes out in
+// screen_format so it can be drawn 1:1; everything else is ARGB8888. If no
+// thread can be started the loading is done before this returns, and the
+// results are polled the same way.
+void BootLoad_Start(int screen_w, int screen_h, Uint32 screen_format);
+
+// Render thread: next finished piece of work, false if there is none yet
+bool BootLoad_Poll(struct boot_msg* out);
+
+// The asset a BOOT_ASSET index refers to
+const struct asset_item* BootLoad_Asset(int index);
+
+// Font pointers (owned by font_cache), valid from BOOT_FONTS. Until
+// BOOT_DONE they may only be used as keys (label_adopt), not to render.
+void BootLoad_Fonts(struct boot_fonts* out);
+
+// Whether the assets came from the asset pack rather than the media files
+bool BootLoad_UsedPack(void);
+
+// Loader time from start to the last asset (pack, fonts and assets), valid
+// once BOOT_DONE has been polled
+uint32_t BootLoad_Millis(void);
+
+// Stop and join the loader, free unpolled surfaces and the pack data.
+// Safe to call twice.
+void BootLoad_Stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_LOAD_H
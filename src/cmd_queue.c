@@ -0,0 +1,249 @@
+// cmd_queue.c - XiFi command jobs, run on the network reactor
+#include "cmd_queue.h"
+#include "net_reactor.h"
+#include "xifi_detect.h"
+#include "spsc.h"
+#include "net_stats.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define CMD_JOB_SLOTS     8       // jobs waiting for the reactor (power of 2)
+#define CMD_DONE_SLOTS    128     // results waiting for the UI (power of 2)
+#define CMD_TIMEOUT_MS    1500
+#define CMD_IDLE_CLOSE_MS 10000   // drop kept-alive connections when idle
+
+// One push: the same commands for one or more devices
+struct cmd_job {
+    int first_id;
+    Uint64 queued_at;   // performance counter at push
+    int n_ips, n;
+    char ips[SEND_FANOUT_MAX][32];
+    struct { char cmd[8]; char arg[72]; } cmds[CMD_JOB_MAX];   // arg: hex of up to 32 chars
+};
+
+struct cmd_done {
+    int id;
+    struct send_result res;
+};
+
+static struct cmd_job job_items[CMD_JOB_SLOTS];
+static struct cmd_done done_items[CMD_DONE_SLOTS];
+static struct spsc_ring jobs, done;   // UI -> reactor, reactor -> UI
+static SDL_atomic_t dropped;
+static int next_id = 1;               // UI thread only
+static int rings_ready = 0;
+static int started = 0;        // reactor running: jobs will be picked up
+
+// Reactor thread: the job in flight and one connection per device slot,
+// kept alive between jobs
+struct cmd_slot {
+    struct cmd_conn c;
+    int fd;          // watched socket, -1 if none
+    int in_job;
+};
+
+static struct cmd_job cur;
+static int busy = 0;
+static struct xifi_cmd cur_cmds[CMD_JOB_MAX];
+static struct send_result cur_res[SEND_FANOUT_MAX * CMD_JOB_MAX];
+static int cur_slot[SEND_FANOUT_MAX];
+static struct cmd_slot slots[SEND_FANOUT_MAX];
+static struct tw_timer deadline_timer, idle_timer;
+
+static void SlotIO(void* arg, int readable, int writable);
+
+// Keep the reactor's watch in step with the connection's socket and phase
+static void SlotSync(struct cmd_slot* s) {
+    int r, w;
+    int fd = cmd_conn_fd(&s->c, &r, &w);
+    if (s->fd >= 0 && s->fd != fd) net_unwatch(s->fd);
+    s->fd = fd;
+    if (fd >= 0 && !net_watch(fd, r, w, SlotIO, s)) {
+        cmd_conn_abort(&s->c, SEND_ERR_SOCKET);
+        s->fd = -1;
+    }
+}
+
+static void CloseAll(void) {
+    for (int j = 0; j < SEND_FANOUT_MAX; j++) {
+        cmd_conn_close(&slots[j].c);
+        SlotSync(&slots[j]);
+    }
+}
+
+static void PostResult(int id, const struct send_result* res) {
+    Uint64 waited = SDL_GetPerformanceCounter() - cur.queued_at;
+    net_stats_result(res, (uint32_t)(waited * 1000000 / SDL_GetPerformanceFrequency()));
+    struct cmd_done d = { id, *res };
+    if (!spsc_push(&done, &d)) SDL_AtomicAdd(&dropped, 1);
+}
+
+static void IdleClose(void* arg) {
+    CloseAll();
+}
+
+static void JobFinish(void) {
+    net_timer_cancel(&deadline_timer);
+    for (int k = 0; k < cur.n_ips; k++) {
+        slots[cur_slot[k]].in_job = 0;
+        for (int i = 0; i < cur.n; i++)
+            PostResult(cur.first_id + k * cur.n + i, &cur_res[k * cur.n + i]);
+    }
+    busy = 0;
+    net_timer(&idle_timer, CMD_IDLE_CLOSE_MS, IdleClose, NULL);
+}
+
+static void JobCheck(void) {
+    for (int k = 0; k < cur.n_ips; k++) {
+        if (slots[cur_slot[k]].c.phase != CONN_IDLE) return;
+    }
+    JobFinish();
+}
+
+static void JobTimeout(void* arg) {
+    for (int k = 0; k < cur.n_ips; k++) {
+        struct cmd_slot* s = &slots[cur_slot[k]];
+        if (s->c.phase != CONN_IDLE) cmd_conn_abort(&s->c, SEND_ERR_TIMEOUT);
+        SlotSync(s);
+    }
+    JobFinish();
+}
+
+static void SlotIO(void* arg, int readable, int writable) {
+    struct cmd_slot* s = arg;
+    cmd_conn_io(&s->c, readable, writable);
+    SlotSync(s);
+    if (busy && s->in_job) JobCheck();
+}
+
+// Give every device of the job a slot: its own kept-alive connection if
+// there is one, else a closed slot, else any slot the job isn't using
+static void AssignSlots(void) {
+    for (int k = 0; k < cur.n_ips; k++) {
+        cur_slot[k] = -1;
+        for (int j = 0; j < SEND_FANOUT_MAX && cur_slot[k] < 0; j++) {
+            if (!slots[j].in_job && strcmp(slots[j].c.ip, cur.ips[k]) == 0) cur_slot[k] = j;
+        }
+        if (cur_slot[k] >= 0) slots[cur_slot[k]].in_job = 1;
+    }
+    for (int pass = 0; pass < 2; pass++) {
+        for (int k = 0; k < cur.n_ips; k++) {
+            for (int j = 0; j < SEND_FANOUT_MAX && cur_slot[k] < 0; j++) {
+                if (slots[j].in_job || (pass == 0 && slots[j].c.sock >= 0)) continue;
+                cur_slot[k] = j;
+                slots[j].in_job = 1;
+            }
+        }
+    }
+}
+
+static void JobStart(void) {
+    for (int i = 0; i < cur.n; i++) cur_cmds[i] = (struct xifi_cmd){ cur.cmds[i].cmd, cur.cmds[i].arg };
+    net_timer_cancel(&idle_timer);
+
+    if (!XiFi_IsPresent()) {
+        // Heartbeat lost the device: fail fast instead of waiting on connect
+        CloseAll();
+        for (int k = 0; k < cur.n_ips; k++) {
+            for (int i = 0; i < cur.n; i++) {
+                struct send_result r;
+                memset(&r, 0, sizeof(r));
+                r.status = SEND_ERR_OFFLINE;
+                PostResult(cur.first_id + k * cur.n + i, &r);
+            }
+        }
+        return;
+    }
+
+    AssignSlots();
+    busy = 1;
+    for (int k = 0; k < cur.n_ips; k++) {
+        struct cmd_slot* s = &slots[cur_slot[k]];
+        cmd_conn_begin(&s->c, cur.ips[k], cur_cmds, cur.n, &cur_res[k * cur.n]);
+        SlotSync(s);
+    }
+    net_timer(&deadline_timer, CMD_TIMEOUT_MS, JobTimeout, NULL);
+    JobCheck();
+}
+
+void CmdQueue_ReactorBegin(void) {
+    for (int j = 0; j < SEND_FANOUT_MAX; j++) {
+        cmd_conn_init(&slots[j].c);
+        slots[j].fd = -1;
+        slots[j].in_job = 0;
+    }
+    busy = 0;
+}
+
+// One job at a time; its devices run concurrently
+void CmdQueue_ReactorPoll(void) {
+    while (!busy && spsc_pop(&jobs, &cur)) JobStart();
+}
+
+void CmdQueue_ReactorEnd(void) {
+    net_timer_cancel(&deadline_timer);
+    net_timer_cancel(&idle_timer);
+    for (int j = 0; j < SEND_FANOUT_MAX; j++) slots[j].c.phase = CONN_IDLE;
+    CloseAll();
+    busy = 0;
+}
+
+bool CmdQueue_Start(void) {
+    if (!rings_ready) {
+        spsc_init(&jobs, job_items, CMD_JOB_SLOTS, sizeof(job_items[0]));
+        spsc_init(&done, done_items, CMD_DONE_SLOTS, sizeof(done_items[0]));
+        rings_ready = 1;
+    }
+    if (!NetReactor_Start()) return false;
+    started = 1;
+    return true;
+}
+
+int CmdQueue_PushFanout(const char* const* ips, int n_ips, const struct xifi_cmd* cmds, int n) {
+    if (!started || !ips || n_ips <= 0 || n_ips > SEND_FANOUT_MAX || !cmds || n <= 0 ||
+        n > CMD_JOB_MAX)
+        return 0;
+    for (int i = 0; i < n; i++) {
+        if (!cmds[i].cmd_hex) return 0;
+    }
+    for (int k = 0; k < n_ips; k++) {
+        if (!ips[k]) return 0;
+    }
+
+    struct cmd_job job;
+    job.first_id = next_id;
+    job.queued_at = SDL_GetPerformanceCounter();
+    job.n_ips = n_ips;
+    job.n = n;
+    for (int k = 0; k < n_ips; k++) snprintf(job.ips[k], sizeof(job.ips[k]), "%s", ips[k]);
+    for (int i = 0; i < n; i++) {
+        snprintf(job.cmds[i].cmd, sizeof(job.cmds[i].cmd), "%s", cmds[i].cmd_hex);
+        snprintf(job.cmds[i].arg, sizeof(job.cmds[i].arg), "%s", cmds[i].hex_arg ? cmds[i].hex_arg : "");
+    }
+    if (!spsc_push(&jobs, &job)) return 0;
+    next_id += n_ips * n;
+    NetReactor_Wake();
+    return next_id - 1;
+}
+
+int CmdQueue_PushMany(const char* ip, const struct xifi_cmd* cmds, int n) {
+    return CmdQueue_PushFanout(&ip, 1, cmds, n);
+}
+
+int CmdQueue_Push(const char* ip, const char* cmd_hex, const char* hex_arg) {
+    struct xifi_cmd c = { cmd_hex, hex_arg };
+    return CmdQueue_PushMany(ip, &c, 1);
+}
+
+int CmdQueue_PollResult(int* id, struct send_result* out) {
+    struct cmd_done d;
+    if (!started || !spsc_pop(&done, &d)) return 0;
+    *id = d.id;
+    *out = d.res;
+    return 1;
+}
+
+uint32_t CmdQueue_Dropped(void) {
+    return (uint32_t)SDL_AtomicGet(&dropped);
+}
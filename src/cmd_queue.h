@@ -0,0 +1,56 @@
+#ifndef CMD_QUEUE_H
+#define CMD_QUEUE_H
+
+#include <SDL.h>
+#include "send_cmd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Commands are sent by the network reactor so the UI never blocks. Jobs go
+// to it and results come back through lock-free single-producer/single-
+// consumer rings: call the Push functions and CmdQueue_PollResult() from one
+// thread (the UI) only.
+
+// Most commands in one job (per device)
+#define CMD_JOB_MAX 8
+
+// Start the network reactor if needed (safe to call more than once).
+// NetReactor_Stop() shuts it down. Returns false if the reactor can't run;
+// nothing can be queued then.
+bool CmdQueue_Start(void);
+
+// Queue a command for ip. hex_arg may be NULL. Returns the command id (> 0),
+// or 0 if the queue is full or the reactor isn't running.
+int CmdQueue_Push(const char* ip, const char* cmd_hex, const char* hex_arg);
+
+// Queue up to CMD_JOB_MAX commands for ip as one job so they share one
+// pipelined (or batched) round trip. Ids are consecutive; returns the id of
+// the last command, or 0 if the job doesn't fit.
+int CmdQueue_PushMany(const char* ip, const struct xifi_cmd* cmds, int n);
+
+// Queue the same n commands for each of n_ips devices (at most
+// SEND_FANOUT_MAX); the reactor sends them to all devices concurrently.
+// Ids are consecutive and device-major: ips[k]'s command i gets
+// last - (n_ips*n - 1) + k*n + i. Returns the last id, or 0 if the job
+// doesn't fit.
+int CmdQueue_PushFanout(const char* const* ips, int n_ips, const struct xifi_cmd* cmds, int n);
+
+// Take the next finished command, in completion order. Returns 0 if none
+// is waiting.
+int CmdQueue_PollResult(int* id, struct send_result* out);
+
+// Results thrown away because the UI stopped draining them
+uint32_t CmdQueue_Dropped(void);
+
+// Called by the network reactor on its own thread
+void CmdQueue_ReactorBegin(void);
+void CmdQueue_ReactorPoll(void);
+void CmdQueue_ReactorEnd(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CMD_QUEUE_H
@@ -0,0 +1,57 @@
+// damage.c - dirty rectangle tracking so unchanged frames are never redrawn
+#include "damage.h"
+
+#define DAMAGE_MAX_RECTS 8
+
+static SDL_Rect screen_rc = {0, 0, 0, 0};
+static SDL_Rect rects[DAMAGE_MAX_RECTS];
+static int nrects = 0;
+
+void damage_init(int screen_w, int screen_h) {
+    screen_rc = (SDL_Rect){0, 0, screen_w, screen_h};
+    nrects = 0;
+}
+
+void damage_add(const SDL_Rect* r) {
+    SDL_Rect rc;
+    if (!r || !SDL_IntersectRect(r, &screen_rc, &rc)) return;
+
+    // Fold into any rectangle it touches; keep folding since the grown
+    // rectangle may now overlap others in the list.
+    int merged = 1;
+    while (merged) {
+        merged = 0;
+        for (int i = 0; i < nrects; i++) {
+            if (SDL_HasIntersection(&rects[i], &rc)) {
+                SDL_UnionRect(&rects[i], &rc, &rc);
+                rects[i] = rects[--nrects];
+                merged = 1;
+                break;
+            }
+        }
+    }
+
+    if (nrects == DAMAGE_MAX_RECTS) {
+        // Out of slots: collapse everything into one bounding box
+        for (int i = 0; i < nrects; i++) SDL_UnionRect(&rects[i], &rc, &rc);
+        nrects = 0;
+    }
+    rects[nrects++] = rc;
+}
+
+void damage_add_all(void) {
+    rects[0] = screen_rc;
+    nrects = 1;
+}
+
+int damage_count(void) {
+    return nrects;
+}
+
+const SDL_Rect* damage_get(int i) {
+    return (i >= 0 && i < nrects) ? &rects[i] : NULL;
+}
+
+void damage_clear(void) {
+    nrects = 0;
+}
@@ -0,0 +1,30 @@
+#ifndef DAMAGE_H
+#define DAMAGE_H
+
+#include <SDL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Set the screen bounds that all dirty rectangles are clipped to.
+void damage_init(int screen_w, int screen_h);
+
+// Mark a region as needing to be recomposited on the next frame.
+void damage_add(const SDL_Rect* r);
+
+// Mark the whole screen dirty (first frame, overlay open/close).
+void damage_add_all(void);
+
+// Dirty rectangles collected since the last damage_clear().
+int damage_count(void);
+const SDL_Rect* damage_get(int i);
+
+// Forget all dirty rectangles (call after presenting).
+void damage_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DAMAGE_H
@@ -0,0 +1,163 @@
+// font_cache.c - one in-memory font file, its sizes, and a glyph atlas per size
+#include "font_cache.h"
+#include "img_scale.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FONT_CACHE_SIZES 4
+#define GLYPH_FIRST      32     // ' '
+#define GLYPH_LAST       126    // '~'
+#define GLYPH_COUNT      (GLYPH_LAST - GLYPH_FIRST + 1)
+#define ATLAS_WIDTH      512
+
+struct glyph {
+    SDL_Rect src;              // in the atlas; w = 0 if it did not render
+    int advance;
+};
+
+struct font_entry {
+    TTF_Font* font;
+    int px;
+    SDL_Surface* atlas_surf;   // rasterized, waiting to be uploaded
+    SDL_Texture* atlas;        // white glyphs, tinted per draw
+    bool prepared;
+    struct glyph glyphs[GLYPH_COUNT];
+};
+
+static unsigned char* data = NULL;
+static size_t data_size = 0;
+static struct font_entry fonts[FONT_CACHE_SIZES];
+
+bool font_cache_load(const char* path) {
+    font_cache_clear();
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    long size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+    if (size > 0 && fseek(f, 0, SEEK_SET) == 0 && (data = malloc((size_t)size)) != NULL &&
+        fread(data, 1, (size_t)size, f) == (size_t)size) {
+        data_size = (size_t)size;
+    } else {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data != NULL;
+}
+
+TTF_Font* font_cache_open(int px) {
+    if (!data) return NULL;
+    struct font_entry* slot = NULL;
+    for (int i = 0; i < FONT_CACHE_SIZES; i++) {
+        if (fonts[i].font && fonts[i].px == px) return fonts[i].font;
+        if (!fonts[i].font && !slot) slot = &fonts[i];
+    }
+    if (!slot) return NULL;
+    // The RWops only reads the shared buffer; TTF_CloseFont frees it
+    SDL_RWops* rw = SDL_RWFromConstMem(data, (int)data_size);
+    slot->font = rw ? TTF_OpenFontRW(rw, 1, px) : NULL;
+    slot->px = px;
+    return slot->font;
+}
+
+static struct font_entry* find(TTF_Font* font) {
+    for (int i = 0; font && i < FONT_CACHE_SIZES; i++) {
+        if (fonts[i].font == font) return &fonts[i];
+    }
+    return NULL;
+}
+
+// Shelf-packs every glyph into one ARGB8888 surface, rendered in white so a
+// color mod can tint it
+static void rasterize(struct font_entry* e) {
+    SDL_Surface* g[GLYPH_COUNT];
+    int x = 0, y = 0, shelf = 0;
+    e->prepared = true;
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        struct glyph* gl = &e->glyphs[i];
+        memset(gl, 0, sizeof(*gl));
+        TTF_GlyphMetrics(e->font, (Uint16)(GLYPH_FIRST + i), NULL, NULL, NULL, NULL, &gl->advance);
+        g[i] = TTF_RenderGlyph_Blended(e->font, (Uint16)(GLYPH_FIRST + i), (SDL_Color){255,255,255,255});
+        if (!g[i]) continue;
+        if (x + g[i]->w > ATLAS_WIDTH) {
+            x = 0;
+            y += shelf;
+            shelf = 0;
+        }
+        gl->src = (SDL_Rect){ x, y, g[i]->w, g[i]->h };
+        x += g[i]->w;
+        if (g[i]->h > shelf) shelf = g[i]->h;
+    }
+    e->atlas_surf = SDL_CreateRGBSurfaceWithFormat(0, ATLAS_WIDTH, y + shelf, 32, SDL_PIXELFORMAT_ARGB8888);
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        if (!g[i]) continue;
+        if (e->atlas_surf) {
+            SDL_SetSurfaceBlendMode(g[i], SDL_BLENDMODE_NONE);   // copy alpha as is
+            SDL_BlitSurface(g[i], NULL, e->atlas_surf, &e->glyphs[i].src);
+        } else {
+            e->glyphs[i].src.w = 0;
+        }
+        SDL_FreeSurface(g[i]);
+    }
+}
+
+void font_cache_prepare(TTF_Font* font) {
+    struct font_entry* e = find(font);
+    if (e && !e->prepared) rasterize(e);
+}
+
+void font_cache_size(TTF_Font* font, const char* text, int* w, int* h) {
+    struct font_entry* e = find(font);
+    *w = *h = 0;
+    if (!e || !text) return;
+    if (!e->prepared) rasterize(e);
+    int pen = 0, prev = 0;
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        if (*p < GLYPH_FIRST || *p > GLYPH_LAST) continue;
+        const struct glyph* gl = &e->glyphs[*p - GLYPH_FIRST];
+        if (prev) pen += TTF_GetFontKerningSizeGlyphs(font, (Uint16)prev, *p);
+        if (pen + gl->src.w > *w) *w = pen + gl->src.w;
+        pen += gl->advance;
+        prev = *p;
+    }
+    if (*w) *h = TTF_FontHeight(font);
+}
+
+void font_cache_draw(SDL_Renderer* r, TTF_Font* font, const char* text, int x, int y, SDL_Color col) {
+    struct font_entry* e = find(font);
+    if (!e || !text || !text[0]) return;
+    if (!e->prepared) rasterize(e);
+    if (!e->atlas && e->atlas_surf) {
+        e->atlas = img_texture(r, e->atlas_surf);
+        if (e->atlas) SDL_SetTextureBlendMode(e->atlas, SDL_BLENDMODE_BLEND);
+        SDL_FreeSurface(e->atlas_surf);
+        e->atlas_surf = NULL;
+    }
+    if (!e->atlas) return;
+    SDL_SetTextureColorMod(e->atlas, col.r, col.g, col.b);
+    SDL_SetTextureAlphaMod(e->atlas, col.a);
+    int pen = x, prev = 0;
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        if (*p < GLYPH_FIRST || *p > GLYPH_LAST) continue;
+        const struct glyph* gl = &e->glyphs[*p - GLYPH_FIRST];
+        if (prev) pen += TTF_GetFontKerningSizeGlyphs(font, (Uint16)prev, *p);
+        if (gl->src.w) {
+            SDL_Rect dst = { pen, y, gl->src.w, gl->src.h };
+            SDL_RenderCopy(r, e->atlas, &gl->src, &dst);
+        }
+        pen += gl->advance;
+        prev = *p;
+    }
+}
+
+void font_cache_clear(void) {
+    for (int i = 0; i < FONT_CACHE_SIZES; i++) {
+        if (fonts[i].atlas) SDL_DestroyTexture(fonts[i].atlas);
+        if (fonts[i].atlas_surf) SDL_FreeSurface(fonts[i].atlas_surf);
+        if (fonts[i].font) TTF_CloseFont(fonts[i].font);
+    }
+    memset(fonts, 0, sizeof(fonts));
+    free(data);
+    data = NULL;
+    data_size = 0;
+}
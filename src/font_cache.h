@@ -0,0 +1,44 @@
+#ifndef FONT_CACHE_H
+#define FONT_CACHE_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One font file, read once and shared by every size opened from it, plus a
+// glyph atlas per size for text that changes at runtime (IP address,
+// command feedback): each printable ASCII glyph is rasterized once and
+// strings are drawn as one quad per glyph, with no TTF rendering or texture
+// creation per string.
+
+// Reads the font file into memory with one read. Returns false if it can't.
+bool font_cache_load(const char* path);
+
+// The font at px pixels over the loaded file, opened on first use and owned
+// by the cache. NULL if nothing is loaded. Not thread safe: one thread at a
+// time (the loader, then the render thread).
+TTF_Font* font_cache_open(int px);
+
+// Rasterize font's glyph atlas now (CPU only, any thread), so the first
+// font_cache_draw only has to upload it
+void font_cache_prepare(TTF_Font* font);
+
+// Size of text as font_cache_draw draws it
+void font_cache_size(TTF_Font* font, const char* text, int* w, int* h);
+
+// Draws text with its top-left corner at x,y from font's glyph atlas
+// (render thread only). Characters outside printable ASCII are skipped.
+void font_cache_draw(SDL_Renderer* r, TTF_Font* font, const char* text, int x, int y, SDL_Color col);
+
+// Closes every font, destroys the atlases and frees the file data
+void font_cache_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FONT_CACHE_H
@@ -0,0 +1,74 @@
+# host.mk - native Linux build of XiFi Config, for profiling with standard
+# Linux tools. Needs SDL2, SDL2_ttf and SDL2_image development packages.
+#
+#   make host                        -> build-host/xifi-config
+#   XIFI_MEDIA=../media build-host/xifi-config
+#   make sim                         -> build-host/xifi-sim, build-host/xifi-load
+#   make bake [MEDIA_DIR=../media]   -> asset packs in MEDIA_DIR/pack
+
+HOST_CC     ?= cc
+HOST_OUT    ?= $(CURDIR)/build-host
+HOST_BIN     = $(HOST_OUT)/xifi-config
+HOST_CFLAGS ?= -O2 -g -Wall
+HOST_CFLAGS += -DXIFI_HOST -I$(CURDIR) $(shell sdl2-config --cflags)
+HOST_LIBS    = $(shell sdl2-config --libs) -lSDL2_ttf -lSDL2_image -lm
+
+ifeq ($(BENCH),y)
+HOST_CFLAGS += -DXIFI_BENCH
+endif
+ifneq ($(AUDIO_SAMPLES),)
+HOST_CFLAGS += -DAUDIO_SAMPLES=$(AUDIO_SAMPLES)
+endif
+ifneq ($(AUDIO_AHEAD_MS),)
+HOST_CFLAGS += -DAUDIO_AHEAD_MS=$(AUDIO_AHEAD_MS)
+endif
+
+HOST_SRCS = $(APP_SRCS) platform_linux.c
+HOST_OBJS = $(addprefix $(HOST_OUT)/,$(HOST_SRCS:.c=.o))
+
+# Device simulator (plain POSIX) and the load generator, which runs the
+# app's own detection and command code against it
+SIM_BIN   = $(HOST_OUT)/xifi-sim
+LOAD_BIN  = $(HOST_OUT)/xifi-load
+LOAD_SRCS = tools/xifi_load.c xifi_detect.c send_cmd.c http_resp.c cmd_queue.c \
+            net_reactor.c timer_wheel.c net_stats.c platform_linux.c
+LOAD_OBJS = $(addprefix $(HOST_OUT)/,$(LOAD_SRCS:.c=.o))
+
+# Asset baker: pre-decoded, pre-scaled startup assets per video mode
+BAKE_BIN  = $(HOST_OUT)/xifi-bake
+BAKE_SRCS = tools/xifi_bake.c asset_list.c img_scale.c
+BAKE_OBJS = $(addprefix $(HOST_OUT)/,$(BAKE_SRCS:.c=.o))
+MEDIA_DIR ?= $(CURDIR)/../media
+
+.PHONY: host sim bake host-clean
+
+host: $(HOST_BIN)
+
+sim: $(SIM_BIN) $(LOAD_BIN)
+
+bake: $(BAKE_BIN)
+	$(BAKE_BIN) $(MEDIA_DIR)
+
+$(HOST_BIN): $(HOST_OBJS)
+	$(HOST_CC) -o $@ $^ $(HOST_LIBS)
+
+$(SIM_BIN): $(CURDIR)/tools/xifi_sim.c | $(HOST_OUT)
+	$(HOST_CC) -O2 -g -Wall -o $@ $< -lpthread
+
+$(LOAD_BIN): $(LOAD_OBJS)
+	$(HOST_CC) -o $@ $^ $(shell sdl2-config --libs)
+
+$(BAKE_BIN): $(BAKE_OBJS)
+	$(HOST_CC) -o $@ $^ $(HOST_LIBS)
+
+$(HOST_OUT)/%.o: $(CURDIR)/%.c | $(HOST_OUT)
+	@mkdir -p $(@D)
+	$(HOST_CC) $(HOST_CFLAGS) -MMD -MP -c -o $@ $<
+
+$(HOST_OUT):
+	mkdir -p $@
+
+host-clean:
+	rm -rf $(HOST_OUT)
+
+-include $(HOST_OBJS:.o=.d) $(LOAD_OBJS:.o=.d) $(BAKE_OBJS:.o=.d)
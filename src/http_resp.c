@@ -0,0 +1,155 @@
+// http_resp.c - streaming HTTP/1.x response parser over a fixed buffer
+#include "http_resp.h"
+#include <string.h>
+
+enum { HDR_OTHER = 0, HDR_CONTENT_LENGTH, HDR_CONNECTION, HDR_XIFI_BATCH };
+
+void http_resp_init(struct http_resp* r) {
+    memset(r, 0, sizeof(*r));
+    r->state = HTTP_STATUS_LINE;
+    r->content_length = -1;
+}
+
+static char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+// Status line: "HTTP/1.x SSS reason\r\n", parsed one byte at a time
+static int status_byte(struct http_resp* r, char c) {
+    static const char proto[] = "HTTP/1.";
+    int p = r->pos++;
+    if (p < 7) return c == proto[p];
+    if (p == 7) {
+        if (c < '0' || c > '9') return 0;
+        r->http_minor = c - '0';
+        return 1;
+    }
+    if (p == 8) return c == ' ';
+    if (p <= 11) {
+        if (c < '0' || c > '9') return 0;
+        r->status = r->status * 10 + (c - '0');
+        return 1;
+    }
+    if (c == '\n') {
+        r->state = HTTP_HEADER_NAME;
+        r->keep_alive = r->http_minor >= 1;  // HTTP/1.1 defaults to keep-alive
+        r->name_len = 0;
+    }
+    return 1;
+}
+
+static void header_done(struct http_resp* r) {
+    r->value[r->value_len] = 0;
+    if (r->hdr == HDR_CONTENT_LENGTH) {
+        long v = 0;
+        for (const char* p = r->value; *p >= '0' && *p <= '9'; p++) v = v * 10 + (*p - '0');
+        r->content_length = v;
+    } else if (r->hdr == HDR_CONNECTION) {
+        if (strcmp(r->value, "close") == 0) r->keep_alive = 0;
+        else if (strcmp(r->value, "keep-alive") == 0) r->keep_alive = 1;
+    } else if (r->hdr == HDR_XIFI_BATCH) {
+        r->xifi_batch = r->value[0] == '1';
+    }
+}
+
+static void headers_finished(struct http_resp* r) {
+    // Interim response (100 Continue, 102 Processing, ...): forget it and
+    // read the real status line that follows. 101 ends HTTP on the socket.
+    if (r->status >= 100 && r->status < 200 && r->status != 101) {
+        http_resp_init(r);
+        return;
+    }
+    r->headers_done = 1;
+    // 101/204/304 never carry a body; without a length the body runs to EOF
+    if (r->status == 101 || r->status == 204 || r->status == 304) {
+        r->content_length = 0;
+    }
+    if (r->content_length < 0) r->keep_alive = 0;
+    r->state = (r->content_length == 0) ? HTTP_DONE : HTTP_BODY;
+}
+
+size_t http_resp_feed(struct http_resp* r, const char* data, size_t len) {
+    size_t i = 0;
+    r->body = NULL;
+    r->body_len = 0;
+
+    while (i < len && r->state != HTTP_DONE && r->state != HTTP_ERROR) {
+        char c = data[i];
+        switch (r->state) {
+            case HTTP_STATUS_LINE:
+                if (!status_byte(r, c)) r->state = HTTP_ERROR;
+                i++;
+                break;
+
+            case HTTP_HEADER_NAME:
+                i++;
+                if (c == '\r') break;
+                if (c == '\n') {
+                    if (r->name_len == 0) headers_finished(r);   // blank line
+                    else r->state = HTTP_ERROR;
+                    break;
+                }
+                if (c == ':') {
+                    r->name[r->name_len < (int)sizeof(r->name) ? r->name_len : (int)sizeof(r->name) - 1] = 0;
+                    r->hdr = strcmp(r->name, "content-length") == 0 ? HDR_CONTENT_LENGTH
+                           : strcmp(r->name, "connection") == 0     ? HDR_CONNECTION
+                           : strcmp(r->name, "x-xifi-batch") == 0   ? HDR_XIFI_BATCH
+                           : HDR_OTHER;
+                    r->value_len = 0;
+                    r->state = HTTP_HEADER_VALUE;
+                    break;
+                }
+                if (r->name_len < (int)sizeof(r->name) - 1) r->name[r->name_len] = lower(c);
+                r->name_len++;
+                break;
+
+            case HTTP_HEADER_VALUE:
+                i++;
+                if (c == '\r') {
+                    r->state = HTTP_HEADER_LF;
+                    break;
+                }
+                if (c == '\n') {
+                    header_done(r);
+                    r->name_len = 0;
+                    r->state = HTTP_HEADER_NAME;
+                    break;
+                }
+                if (r->hdr == HDR_OTHER) break;
+                if ((c == ' ' || c == '\t') && r->value_len == 0) break;  // leading space
+                if (r->value_len < (int)sizeof(r->value) - 1) r->value[r->value_len++] = lower(c);
+                break;
+
+            case HTTP_HEADER_LF:
+                i++;
+                header_done(r);
+                r->name_len = 0;
+                r->state = (c == '\n') ? HTTP_HEADER_NAME : HTTP_ERROR;
+                break;
+
+            case HTTP_BODY: {
+                // Hand out the body in place, never past this response's end
+                size_t avail = len - i;
+                if (r->content_length >= 0 && (long)avail > r->content_length - r->body_seen)
+                    avail = (size_t)(r->content_length - r->body_seen);
+                r->body = data + i;
+                r->body_len = avail;
+                r->body_seen += (long)avail;
+                i += avail;
+                if (r->content_length >= 0 && r->body_seen >= r->content_length)
+                    r->state = HTTP_DONE;
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+    return i;
+}
+
+void http_resp_eof(struct http_resp* r) {
+    if (r->state == HTTP_BODY && r->content_length < 0) r->state = HTTP_DONE;
+    else if (r->state != HTTP_DONE) r->state = HTTP_ERROR;
+    r->keep_alive = 0;
+}
@@ -0,0 +1,59 @@
+#ifndef HTTP_RESP_H
+#define HTTP_RESP_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum http_state {
+    HTTP_STATUS_LINE = 0,
+    HTTP_HEADER_NAME,
+    HTTP_HEADER_VALUE,
+    HTTP_HEADER_LF,
+    HTTP_BODY,
+    HTTP_DONE,
+    HTTP_ERROR
+};
+
+// Incremental HTTP/1.x response parser. Bytes are fed as they arrive, in
+// any split; nothing is allocated and the body is never copied: after each
+// feed, body/body_len point at the body bytes inside the caller's buffer.
+struct http_resp {
+    enum http_state state;
+    int status;             // e.g. 200, valid once headers are parsed
+    int http_minor;         // 0 for HTTP/1.0, 1 for HTTP/1.1
+    long content_length;    // -1 if the header was absent
+    long body_seen;
+    int keep_alive;         // connection usable for the next response
+    int xifi_batch;         // device advertised "X-XiFi-Batch: 1"
+    int headers_done;
+
+    const char* body;       // body bytes from the last feed (into caller data)
+    size_t body_len;
+
+    // Scratch for the header currently being scanned (names are matched
+    // case-insensitively, values only kept for the headers we care about)
+    int pos;
+    int hdr;
+    char name[24];
+    int name_len;
+    char value[16];
+    int value_len;
+};
+
+void http_resp_init(struct http_resp* r);
+
+// Consume bytes. Stops at the end of the response so pipelined data for the
+// next response is left alone; returns how many bytes were used.
+size_t http_resp_feed(struct http_resp* r, const char* data, size_t len);
+
+// The peer closed the connection: completes a body that runs until EOF.
+void http_resp_eof(struct http_resp* r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HTTP_RESP_H
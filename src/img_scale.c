@@ -0,0 +1,119 @@
+// img_scale.c - one-time high quality image resampling at load
+#include "img_scale.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+// Filter taps for one axis: n source indices and weights per output pixel
+struct taps {
+    int n;
+    int* idx;
+    float* w;
+};
+
+static void taps_free(struct taps* t) {
+    free(t->idx);
+    free(t->w);
+}
+
+static bool taps_make(struct taps* t, int src_len, int dst_len) {
+    float scale = (float)src_len / dst_len;
+    float support = scale > 1.0f ? scale : 1.0f;   // triangle half-width in source pixels
+    t->n = (int)ceilf(support) * 2 + 1;
+    t->idx = malloc(sizeof(int) * dst_len * t->n);
+    t->w = malloc(sizeof(float) * dst_len * t->n);
+    if (!t->idx || !t->w) {
+        taps_free(t);
+        return false;
+    }
+    for (int o = 0; o < dst_len; o++) {
+        float center = (o + 0.5f) * scale - 0.5f;
+        int first = (int)floorf(center - support) + 1;
+        int* idx = t->idx + o * t->n;
+        float* w = t->w + o * t->n;
+        float sum = 0.0f;
+        for (int k = 0; k < t->n; k++) {
+            int i = first + k;
+            float d = fabsf(i - center) / support;
+            w[k] = d < 1.0f ? 1.0f - d : 0.0f;
+            idx[k] = i < 0 ? 0 : i >= src_len ? src_len - 1 : i;   // clamp at the edges
+            sum += w[k];
+        }
+        for (int k = 0; k < t->n; k++) w[k] /= sum;
+    }
+    return true;
+}
+
+static Uint8 to_byte(float v) {
+    int i = (int)(v + 0.5f);
+    return (Uint8)(i < 0 ? 0 : i > 255 ? 255 : i);
+}
+
+SDL_Surface* img_scale(SDL_Surface* src, int w, int h, Uint32 format) {
+    SDL_Surface* in = SDL_ConvertSurfaceFormat(src, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_Surface* out = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+    struct taps tx = {0}, ty = {0};
+    float* acc = in ? malloc(sizeof(float) * 4 * in->w) : NULL;
+    bool ok = in && out && acc && taps_make(&tx, in->w, w);
+    if (ok && !taps_make(&ty, in->h, h)) {
+        taps_free(&tx);
+        ok = false;
+    }
+    if (!ok) {
+        free(acc);
+        if (in) SDL_FreeSurface(in);
+        if (out) SDL_FreeSurface(out);
+        return NULL;
+    }
+
+    // Row by row: blend the source rows for this output row, then filter
+    // that one row horizontally. Only a single float row is kept around.
+    for (int y = 0; y < h; y++) {
+        for (int i = 0; i < 4 * in->w; i++) acc[i] = 0.0f;
+        for (int k = 0; k < ty.n; k++) {
+            float wt = ty.w[y * ty.n + k];
+            if (wt == 0.0f) continue;
+            const Uint32* row = (const Uint32*)((const Uint8*)in->pixels + ty.idx[y * ty.n + k] * in->pitch);
+            for (int x = 0; x < in->w; x++) {
+                Uint32 p = row[x];
+                acc[4*x+0] += wt * (float)(p >> 24);
+                acc[4*x+1] += wt * (float)((p >> 16) & 0xFF);
+                acc[4*x+2] += wt * (float)((p >> 8) & 0xFF);
+                acc[4*x+3] += wt * (float)(p & 0xFF);
+            }
+        }
+        Uint32* dst = (Uint32*)((Uint8*)out->pixels + y * out->pitch);
+        for (int x = 0; x < w; x++) {
+            float a = 0.0f, r = 0.0f, g = 0.0f, b = 0.0f;
+            for (int k = 0; k < tx.n; k++) {
+                float wt = tx.w[x * tx.n + k];
+                const float* s = acc + 4 * tx.idx[x * tx.n + k];
+                a += wt * s[0];
+                r += wt * s[1];
+                g += wt * s[2];
+                b += wt * s[3];
+            }
+            dst[x] = (Uint32)to_byte(a) << 24 | (Uint32)to_byte(r) << 16 |
+                     (Uint32)to_byte(g) << 8 | to_byte(b);
+        }
+    }
+    taps_free(&tx);
+    taps_free(&ty);
+    free(acc);
+    SDL_FreeSurface(in);
+
+    if (format == SDL_PIXELFORMAT_ARGB8888) return out;
+    SDL_Surface* native = SDL_ConvertSurfaceFormat(out, format, 0);
+    SDL_FreeSurface(out);
+    return native;
+}
+
+SDL_Texture* img_texture(SDL_Renderer* r, SDL_Surface* s) {
+    SDL_Texture* tex = SDL_CreateTexture(r, s->format->format, SDL_TEXTUREACCESS_STATIC, s->w, s->h);
+    if (tex && SDL_UpdateTexture(tex, NULL, s->pixels, s->pitch) != 0) {
+        SDL_DestroyTexture(tex);
+        tex = NULL;
+    }
+    if (!tex) tex = SDL_CreateTextureFromSurface(r, s);   // format not supported
+    return tex;
+}
@@ -0,0 +1,25 @@
+#ifndef IMG_SCALE_H
+#define IMG_SCALE_H
+
+#include <SDL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Resamples src to w x h with a separable triangle filter whose footprint
+// widens with the reduction, so downscales average every source pixel
+// instead of skipping some, and upscales are bilinear. The result is in
+// format (e.g. the renderer's native format, so drawing it 1:1 is a plain
+// copy). Returns NULL on failure; src is left untouched.
+SDL_Surface* img_scale(SDL_Surface* src, int w, int h, Uint32 format);
+
+// Static texture with the surface's own pixel format and size, so drawing it
+// needs no conversion (render thread only)
+SDL_Texture* img_texture(SDL_Renderer* r, SDL_Surface* s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IMG_SCALE_H
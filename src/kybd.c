@@ -3,6 +3,9 @@
 #include <SDL.h>
 #include <stdint.h>
 #include <string.h>
+#ifdef XIFI_BENCH
+#include "platform.h"
+#endif
 
 // --- Scaling macros for window size ---
 #define SCALEX(x) ((int)((float)(x) * win_w / 1280.0f))
@@ -44,6 +47,7 @@ static int kb_row = 0, kb_col = 0, kb_layout = 0;
 static char kb_buffer[33] = {0};
 static int kb_cpos = 0; // Cursor in buffer
 static int kb_result = KYBD_RUNNING;
+static int kb_dirty = 1; // Anything visible changed since the last draw
 
 // Key repeat
 static int repeat_dir = 0;
@@ -56,6 +60,7 @@ void kybd_update_repeat(void) {
     if (repeat_dir != 0) {
         if (now - repeat_start > REPEAT_DELAY && now - repeat_last > REPEAT_RATE) {
             repeat_last = now;
+            kb_dirty = 1;
             switch (repeat_dir) {
                 case 1: kb_row = (kb_row - 1 + KB_NUM_ROWS) % KB_NUM_ROWS; break;
                 case 2: kb_row = (kb_row + 1) % KB_NUM_ROWS; break;
@@ -82,6 +87,7 @@ void kybd_init(char* init_text, int buflen) {
     kb_cpos = strlen(kb_buffer);
     kb_result = KYBD_RUNNING;
     repeat_dir = 0;
+    kb_dirty = 1;
 }
 
 static void insert_char_at_cursor(char ch) {
@@ -110,6 +116,8 @@ static void move_cursor_right() {
     if (kb_cpos < len) kb_cpos++;
 }
 
+// Reference path: one SDL_RenderDrawPoint per lit pixel. Only used when the
+// glyph atlas could not be created, and as the baseline for kybd_bench().
 void draw_ascii_char(SDL_Renderer* r, char c, int x, int y, SDL_Color fg) {
     if (c < 0x20 || c > 0x7F) c = '?';
     const unsigned char* glyph = font8x8_basic[(unsigned char)c - 0x20];
@@ -132,11 +140,98 @@ void draw_ascii_text(SDL_Renderer* r, const char* s, int x, int y, SDL_Color fg)
     }
 }
 
+// --- Glyph atlas: all 96 glyphs pre-expanded into one white texture ---
+#define ATLAS_COLS 16
+#define ATLAS_ROWS 6
+
+static SDL_Texture* glyph_atlas = NULL;
+static SDL_Renderer* atlas_owner = NULL;
+static int atlas_scale = 0;
+
+// Integer scale keeps the 8x8 glyphs crisp: 1x at 480 lines, 2x at 720
+static int glyph_scale_for(int win_h) {
+    int s = win_h / 360;
+    return s < 1 ? 1 : s;
+}
+
+static int kybd_atlas_ensure(SDL_Renderer* r, int scale) {
+    if (glyph_atlas && atlas_owner == r && atlas_scale == scale) return 1;
+    if (glyph_atlas) SDL_DestroyTexture(glyph_atlas);
+    glyph_atlas = NULL;
+
+    int cell = 8 * scale;
+    SDL_Surface* s = SDL_CreateRGBSurfaceWithFormat(0, ATLAS_COLS * cell, ATLAS_ROWS * cell,
+                                                    32, SDL_PIXELFORMAT_ARGB8888);
+    if (!s) return 0;
+    SDL_LockSurface(s);
+    for (int g = 0; g < 96; g++) {
+        int ox = (g % ATLAS_COLS) * cell, oy = (g / ATLAS_COLS) * cell;
+        for (int row = 0; row < 8 * scale; row++) {
+            uint32_t* px = (uint32_t*)((uint8_t*)s->pixels + (oy + row) * s->pitch) + ox;
+            uint8_t bits = font8x8_basic[g][row / scale];
+            // font8x8 stores the leftmost pixel in bit 0
+            for (int col = 0; col < 8 * scale; col++)
+                px[col] = ((bits >> (col / scale)) & 1) ? 0xFFFFFFFFu : 0x00FFFFFFu;
+        }
+    }
+    SDL_UnlockSurface(s);
+
+    glyph_atlas = SDL_CreateTextureFromSurface(r, s);
+    SDL_FreeSurface(s);
+    if (!glyph_atlas) return 0;
+    SDL_SetTextureBlendMode(glyph_atlas, SDL_BLENDMODE_BLEND);
+    atlas_owner = r;
+    atlas_scale = scale;
+    return 1;
+}
+
+// Width of one glyph as drawn by kybd_text()
+static int glyph_advance(void) {
+    return glyph_atlas ? 8 * atlas_scale : 8;
+}
+
+// Draws a string as one textured quad per glyph from the atlas
+static void kybd_text(SDL_Renderer* r, const char* s, int x, int y, SDL_Color fg) {
+    if (!glyph_atlas) {
+        draw_ascii_text(r, s, x, y, fg);
+        return;
+    }
+    int cell = 8 * atlas_scale;
+    SDL_SetTextureColorMod(glyph_atlas, fg.r, fg.g, fg.b);
+    SDL_SetTextureAlphaMod(glyph_atlas, fg.a);
+    for (; *s; ++s, x += cell) {
+        unsigned char c = (unsigned char)*s;
+        if (c < 0x20 || c > 0x7F) c = '?';
+        if (c == ' ') continue;
+        int g = c - 0x20;
+        SDL_Rect src = { (g % ATLAS_COLS) * cell, (g / ATLAS_COLS) * cell, cell, cell };
+        SDL_Rect dst = { x, y, cell, cell };
+        SDL_RenderCopy(r, glyph_atlas, &src, &dst);
+    }
+}
+
+int kybd_glyph_cell(int win_h) {
+    return 8 * glyph_scale_for(win_h);
+}
+
+void kybd_draw_text(SDL_Renderer* r, int win_h, const char* s, int x, int y, SDL_Color fg) {
+    kybd_atlas_ensure(r, glyph_scale_for(win_h));
+    kybd_text(r, s, x, y, fg);
+}
+
+void kybd_shutdown(void) {
+    if (glyph_atlas) SDL_DestroyTexture(glyph_atlas);
+    glyph_atlas = NULL;
+    atlas_owner = NULL;
+    atlas_scale = 0;
+}
+
 int kybd_handle_event(const SDL_Event* event, char* out, int outlen) {
     if (kb_result != KYBD_RUNNING) return 1;
 
     if (event->type == SDL_CONTROLLERBUTTONDOWN) {
         int but = event->cbutton.button;
+        kb_dirty = 1;
         int len = (kb_row == KB_NUM_ROWS - 1) ? KB_LASTROW_KEYS : strlen(kb_layouts[kb_layout][kb_row]);
         switch (but) {
             case SDL_CONTROLLER_BUTTON_DPAD_UP:
@@ -204,6 +299,7 @@ int kybd_handle_event(const SDL_Event* event, char* out, int outlen) {
             if (event->caxis.value > 16000 && !left_trigger_pressed) {
                 left_trigger_pressed = 1;
                 move_cursor_left();
+                kb_dirty = 1;
             } else if (event->caxis.value < 8000 && left_trigger_pressed) {
                 left_trigger_pressed = 0;
             }
@@ -212,6 +308,7 @@ int kybd_handle_event(const SDL_Event* event, char* out, int outlen) {
             if (event->caxis.value > 16000 && !right_trigger_pressed) {
                 right_trigger_pressed = 1;
                 move_cursor_right();
+                kb_dirty = 1;
             } else if (event->caxis.value < 8000 && right_trigger_pressed) {
                 right_trigger_pressed = 0;
             }
@@ -220,21 +317,70 @@ int kybd_handle_event(const SDL_Event* event, char* out, int outlen) {
     return 0;
 }
 
-void kybd_draw(SDL_Renderer* renderer, int win_w, int win_h, const char* textbuff) {
-    // --- PATCHED FOR SCALING ---
+// Label of a bottom-row key
+static const char* lastrow_label(int col) {
+    if (col == 0) return "<-";
+    if (col == 1) return "SPACE";
+    if (col == 2) return kb_layout == 0 ? "abc" : kb_layout == 1 ? "#!?" : "ABC";
+    return "DONE";
+}
+
+// Bottom-row keys are key_w wide, or wider if their label needs it: the
+// label plus half a glyph of padding on either side
+static int lastrow_key_w(int col, int key_w, int win_h) {
+    int w = ((int)strlen(lastrow_label(col)) + 1) * kybd_glyph_cell(win_h);
+    return w > key_w ? w : key_w;
+}
+
+static int row_width(int row, int key_w, int spacing, int win_h) {
+    if (row != KB_NUM_ROWS - 1) {
+        int len = strlen(kb_layouts[kb_layout][row]);
+        return len * key_w + (len - 1) * spacing;
+    }
+    int w = (KB_LASTROW_KEYS - 1) * spacing;
+    for (int col = 0; col < KB_LASTROW_KEYS; col++) w += lastrow_key_w(col, key_w, win_h);
+    return w;
+}
+
+// Overlay panel and key grid width for the current layout
+static SDL_Rect kybd_overlay_rect(int win_w, int win_h, int* grid_w_out) {
     int key_w = SCALEX(64), key_h = SCALEY(32), spacing = SCALEX(10);
-    int max_cols = 0;
+    int grid_w = 0;
     for (int row = 0; row < KB_NUM_ROWS; ++row) {
-        int len = (row == KB_NUM_ROWS-1) ? KB_LASTROW_KEYS : strlen(kb_layouts[kb_layout][row]);
-        if (len > max_cols) max_cols = len;
+        int w = row_width(row, key_w, spacing, win_h);
+        if (w > grid_w) grid_w = w;
     }
-    int grid_w = max_cols * key_w + (max_cols - 1) * spacing;
     int grid_h = KB_NUM_ROWS * key_h + (KB_NUM_ROWS - 1) * spacing;
+    if (grid_w_out) *grid_w_out = grid_w;
+
+    return (SDL_Rect){
+        win_w / 2 - grid_w / 2 - SCALEX(40),
+        win_h / 2 - grid_h / 2 - SCALEY(70),
+        grid_w + SCALEX(80),
+        grid_h + SCALEY(160)
+    };
+}
 
-    int overlay_x = win_w / 2 - grid_w / 2 - SCALEX(40);
-    int overlay_y = win_h / 2 - grid_h / 2 - SCALEY(70);
-    int overlay_w = grid_w + SCALEX(80);
-    int overlay_h = grid_h + SCALEY(160);
+int kybd_consume_dirty(void) {
+    int d = kb_dirty;
+    kb_dirty = 0;
+    return d;
+}
+
+void kybd_get_bounds(int win_w, int win_h, SDL_Rect* out) {
+    SDL_Rect ov = kybd_overlay_rect(win_w, win_h, NULL);
+    // Include the drop shadow drawn below/right of the panel
+    *out = (SDL_Rect){ ov.x, ov.y, ov.w + SCALEX(16), ov.h + SCALEY(16) };
+}
+
+void kybd_draw(SDL_Renderer* renderer, int win_w, int win_h, const char* textbuff) {
+    // --- PATCHED FOR SCALING ---
+    int key_w = SCALEX(64), key_h = SCALEY(32), spacing = SCALEX(10);
+    int grid_w;
+    SDL_Rect ov = kybd_overlay_rect(win_w, win_h, &grid_w);
+    int overlay_x = ov.x, overlay_y = ov.y, overlay_w = ov.w, overlay_h = ov.h;
+    kybd_atlas_ensure(renderer, glyph_scale_for(win_h));
+    int gw = glyph_advance();
 
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 120);
@@ -255,7 +401,7 @@ void kybd_draw(SDL_Renderer* renderer, int win_w, int win_h, const char* textbuf
     for (; i < blen && j < 39; ++i) dispbuf[j++] = kb_buffer[i];
     dispbuf[j] = 0;
 
-    draw_ascii_text(renderer, dispbuf, bg.x + SCALEX(40), bg.y + SCALEY(30), fg);
+    kybd_text(renderer, dispbuf, bg.x + SCALEX(40), bg.y + SCALEY(30), fg);
 
     int grid_start_x = bg.x + (bg.w - grid_w) / 2;
     int grid_start_y = bg.y + SCALEY(90);
@@ -263,10 +409,11 @@ void kybd_draw(SDL_Renderer* renderer, int win_w, int win_h, const char* textbuf
     for (int row = 0; row < KB_NUM_ROWS; row++) {
         int len = (row == KB_NUM_ROWS-1) ? KB_LASTROW_KEYS : strlen(kb_layouts[kb_layout][row]);
         int y = grid_start_y + row * (key_h + spacing);
-        int row_start_x = grid_start_x + (grid_w - (len * key_w + (len - 1) * spacing)) / 2;
+        int x = grid_start_x + (grid_w - row_width(row, key_w, spacing, win_h)) / 2;
         for (int col = 0; col < len; col++) {
-            int x = row_start_x + col * (key_w + spacing);
-            SDL_Rect kr = { x, y, key_w, key_h };
+            int last = row == KB_NUM_ROWS - 1;
+            SDL_Rect kr = { x, y, last ? lastrow_key_w(col, key_w, win_h) : key_w, key_h };
+            x += kr.w + spacing;
             if (row == kb_row && col == kb_col) {
                 SDL_SetRenderDrawColor(renderer, 0, 220, 0, 255);
             } else {
@@ -277,25 +424,55 @@ void kybd_draw(SDL_Renderer* renderer, int win_w, int win_h, const char* textbuf
             SDL_RenderDrawRect(renderer, &kr);
 
             char key[16] = {0};
-            if (row == KB_NUM_ROWS - 1) {
-                if (col == 0) strcpy(key, "<-");
-                else if (col == 1) strcpy(key, "SPACE");
-                else if (col == 2) {
-                    if (kb_layout == 0) strcpy(key, "abc");
-                    else if (kb_layout == 1) strcpy(key, "#!?");
-                    else strcpy(key, "ABC");
-                }
-                else if (col == 3) strcpy(key, "DONE");
+            if (last) {
+                strcpy(key, lastrow_label(col));
             } else {
                 key[0] = kb_layouts[kb_layout][row][col];
                 key[1] = 0;
             }
-            int tx = kr.x + (kr.w - 8 * strlen(key)) / 2;
-            int ty = kr.y + (kr.h - 8) / 2;
-            draw_ascii_text(renderer, key, tx, ty, fg);
+            int tx = kr.x + (kr.w - gw * (int)strlen(key)) / 2;
+            int ty = kr.y + (kr.h - gw) / 2;
+            kybd_text(renderer, key, tx, ty, fg);
         }
     }
 }
 
 int kybd_get_result(void) { return kb_result; }
 const char* kybd_get_buffer(void) { return kb_buffer; }
+
+#ifdef XIFI_BENCH
+// Draws every key label of every layout plus a full text field
+static void bench_draw_all(SDL_Renderer* r, int use_atlas, SDL_Color fg) {
+    static const char field[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ012345|";
+    int y = 0;
+    for (int l = 0; l < 3; l++) {
+        for (int row = 0; row < KB_NUM_ROWS; row++, y += 20) {
+            if (use_atlas) kybd_text(r, kb_layouts[l][row], 0, y, fg);
+            else draw_ascii_text(r, kb_layouts[l][row], 0, y, fg);
+        }
+    }
+    if (use_atlas) kybd_text(r, field, 0, y, fg);
+    else draw_ascii_text(r, field, 0, y, fg);
+}
+
+void kybd_bench(SDL_Renderer* r, int win_w, int win_h, int iterations) {
+    SDL_Color fg = {255,255,255,255};
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 ticks[2];
+
+    kybd_atlas_ensure(r, glyph_scale_for(win_h));
+    for (int path = 0; path < 2; path++) {
+        Uint64 t0 = SDL_GetPerformanceCounter();
+        for (int i = 0; i < iterations; i++) {
+            bench_draw_all(r, path, fg);
+            SDL_RenderFlush(r);
+        }
+        ticks[path] = SDL_GetPerformanceCounter() - t0;
+    }
+    SDL_RenderClear(r);
+
+    plat_log("kybd bench (%d iters, %dx%d, atlas %dx):\n", iterations, win_w, win_h, atlas_scale);
+    plat_log("  points: %u us/frame\n", (unsigned)(ticks[0] * 1000000 / freq / iterations));
+    plat_log("  atlas:  %u us/frame\n", (unsigned)(ticks[1] * 1000000 / freq / iterations));
+}
+#endif
@@ -11,6 +11,23 @@
 void kybd_init(char* textbuf, int buflen);
 int kybd_handle_event(const SDL_Event* event, char* textbuf, int buflen);
 void kybd_draw(SDL_Renderer* renderer, int win_w, int win_h, const char* textbuf);
+void kybd_update_repeat(void);
+// Draws ASCII text with the keyboard's 8x8 glyph atlas at the scale used
+// for win_h (debug overlay); each glyph takes kybd_glyph_cell() pixels
+void kybd_draw_text(SDL_Renderer* renderer, int win_h, const char* s, int x, int y, SDL_Color fg);
+int kybd_glyph_cell(int win_h);
+// Releases the glyph atlas (call before destroying the renderer)
+void kybd_shutdown(void);
+
+#ifdef XIFI_BENCH
+// Times the per-pixel glyph path against the atlas path
+void kybd_bench(SDL_Renderer* renderer, int win_w, int win_h, int iterations);
+#endif
+
+// Returns 1 once after any visible keyboard change (for dirty-region redraw)
+int kybd_consume_dirty(void);
+// Screen area covered by the keyboard overlay, including its shadow
+void kybd_get_bounds(int win_w, int win_h, SDL_Rect* out);
 
 int kybd_get_result(void);
 const char* kybd_get_buffer(void);
@@ -0,0 +1,104 @@
+// label_cache.c - keeps TTF text rasterized as textures between frames
+#include "label_cache.h"
+#include <string.h>
+#include <stdint.h>
+
+#define LABEL_CACHE_SIZE 64
+#define LABEL_TEXT_MAX   64
+
+struct label_entry {
+    struct label lbl;
+    TTF_Font* font;
+    SDL_Color col;
+    uint32_t hash;
+    uint32_t last_use;
+    char text[LABEL_TEXT_MAX];
+};
+
+static struct label_entry cache[LABEL_CACHE_SIZE];
+static uint32_t use_clock = 0;
+
+// FNV-1a over the string, folded with the font pointer and the color
+static uint32_t label_hash(TTF_Font* font, const char* text, SDL_Color col) {
+    uint32_t h = 2166136261u;
+    for (; *text; text++) {
+        h ^= (unsigned char)*text;
+        h *= 16777619u;
+    }
+    h ^= (uint32_t)(uintptr_t)font;
+    h *= 16777619u;
+    h ^= ((uint32_t)col.r << 24) | ((uint32_t)col.g << 16) | ((uint32_t)col.b << 8) | col.a;
+    h *= 16777619u;
+    return h;
+}
+
+// Finds (font, text, col); on a miss returns NULL and the slot to fill
+static struct label_entry* label_find(TTF_Font* font, const char* text, SDL_Color col,
+                                      uint32_t h, struct label_entry** victim_out) {
+    struct label_entry* victim = &cache[0];
+    for (int i = 0; i < LABEL_CACHE_SIZE; i++) {
+        struct label_entry* e = &cache[i];
+        if (e->lbl.tex && e->hash == h && e->font == font &&
+            e->col.r == col.r && e->col.g == col.g && e->col.b == col.b && e->col.a == col.a &&
+            strcmp(e->text, text) == 0) {
+            e->last_use = ++use_clock;
+            return e;
+        }
+        // Prefer an empty slot, otherwise the least recently used one
+        if (!victim->lbl.tex) continue;
+        if (!e->lbl.tex || e->last_use < victim->last_use) victim = e;
+    }
+    *victim_out = victim;
+    return NULL;
+}
+
+static void label_store(struct label_entry* victim, TTF_Font* font, const char* text, SDL_Color col,
+                        uint32_t h, SDL_Texture* tex, int w, int hgt) {
+    if (victim->lbl.tex) SDL_DestroyTexture(victim->lbl.tex);
+    victim->lbl = (struct label){ tex, w, hgt };
+    victim->font = font;
+    victim->col = col;
+    victim->hash = h;
+    victim->last_use = ++use_clock;
+    strcpy(victim->text, text);
+}
+
+const struct label* label_get(SDL_Renderer* r, TTF_Font* font, const char* text, SDL_Color col) {
+    if (!font || !text || !text[0]) return NULL;
+    if (strlen(text) >= LABEL_TEXT_MAX) return NULL;
+
+    uint32_t h = label_hash(font, text, col);
+    struct label_entry* victim;
+    struct label_entry* hit = label_find(font, text, col, h, &victim);
+    if (hit) return &hit->lbl;
+
+    // Miss: rasterize once and keep the texture
+    SDL_Surface* s = TTF_RenderText_Blended(font, text, col);
+    if (!s) return NULL;
+    SDL_Texture* tex = SDL_CreateTextureFromSurface(r, s);
+    int w = s->w, hgt = s->h;
+    SDL_FreeSurface(s);
+    if (!tex) return NULL;
+
+    label_store(victim, font, text, col, h, tex, w, hgt);
+    return &victim->lbl;
+}
+
+void label_adopt(TTF_Font* font, const char* text, SDL_Color col, SDL_Texture* tex, int w, int h) {
+    if (!font || !text || !text[0] || strlen(text) >= LABEL_TEXT_MAX) {
+        SDL_DestroyTexture(tex);
+        return;
+    }
+    uint32_t hash = label_hash(font, text, col);
+    struct label_entry* victim;
+    struct label_entry* hit = label_find(font, text, col, hash, &victim);
+    label_store(hit ? hit : victim, font, text, col, hash, tex, w, h);
+}
+
+void label_cache_clear(void) {
+    for (int i = 0; i < LABEL_CACHE_SIZE; i++) {
+        if (cache[i].lbl.tex) SDL_DestroyTexture(cache[i].lbl.tex);
+    }
+    memset(cache, 0, sizeof(cache));
+    use_clock = 0;
+}
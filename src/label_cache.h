@@ -0,0 +1,33 @@
+#ifndef LABEL_CACHE_H
+#define LABEL_CACHE_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A rasterized text label owned by the cache. Valid until it is evicted,
+// so callers should look labels up again each frame instead of holding them.
+struct label {
+    SDL_Texture* tex;
+    int w, h;
+};
+
+// Returns the cached label for (font, text, color), rasterizing it on the
+// first request only. Returns NULL if the text could not be rendered.
+const struct label* label_get(SDL_Renderer* r, TTF_Font* font, const char* text, SDL_Color col);
+
+// Hands the cache an already rasterized label for (font, text, color), e.g.
+// one from the asset pack, so label_get never renders it. The cache owns tex.
+void label_adopt(TTF_Font* font, const char* text, SDL_Color col, SDL_Texture* tex, int w, int h);
+
+// Destroys every cached texture (call on video mode change or shutdown).
+void label_cache_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LABEL_CACHE_H
@@ -1,116 +1,253 @@
-#include <hal/video.h>
-#include <hal/debug.h>
 #include <SDL.h>
 #include <SDL_image.h>
 #include <SDL_ttf.h>
-#include <windows.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include <nxdk/net.h>
+#include <string.h>
+#include "platform.h"
 #include "xifi_detect.h"
 #include "send_cmd.h"
+#include "cmd_queue.h"
+#include "net_reactor.h"
+#include "net_stats.h"
+#include "audio_stream.h"
+#include "audio_gain.h"
 #include "kybd.h"
-
-#define MUSIC_VOLUME      0.3f
+#include "label_cache.h"
+#include "damage.h"
+#include "oct_cache.h"
+#include "img_scale.h"
+#include "asset_list.h"
+#include "boot_load.h"
+#include "font_cache.h"
+
+#define MUSIC_VOLUME      30     // percent at startup
+#define VOLUME_STEP       10     // percent per trigger pull
+#define TRIGGER_PRESS     16000  // axis value that counts as a trigger pull
+#ifndef AUDIO_SAMPLES
+#define AUDIO_SAMPLES     1024   // frames per audio callback (make AUDIO_SAMPLES=n)
+#endif
+#ifndef AUDIO_AHEAD_MS
+#define AUDIO_AHEAD_MS    500    // music decoded ahead of playback (make AUDIO_AHEAD_MS=n)
+#endif
 #define SCREEN_WIDTH_DEF  1280
 #define SCREEN_HEIGHT_DEF 720
-#define MENU_ITEM_COUNT   7
+#define MENU_ITEM_COUNT   UI_MENU_ITEMS
 #define MENU_REPEAT_DELAY 200
 #define MENU_REPEAT_RATE  60
+#define STATS_REFRESH_MS  500
+#define STATS_MAX_LINES   12
+#define STATS_FILE        "net_stats.txt"
+#define BOOT_TIMES_FILE   "boot_times.txt"   // one line appended per boot
 
 static int screen_width = SCREEN_WIDTH_DEF, screen_height = SCREEN_HEIGHT_DEF;
-static FILE* audio_file = NULL;
 
-// --- Audio callback: applies volume scaling and loops audio ---
-void AudioCallback(void* userdata, Uint8* stream, int len) {
-    if (!audio_file) {
-        SDL_memset(stream, 0, len);
+// --- Transient command feedback shown at the bottom of the screen ---
+static char cmd_msg[48] = "";
+static SDL_Color cmd_msg_col = {255,255,255,255};
+static uint32_t cmd_msg_until = 0;   // 0 = stays until replaced
+static int cmd_msg_changed = 0;
+
+// The job whose results we are waiting for: ids run device-major from
+// cmd_first_id, cmd_per_dev commands per device; only each device's last
+// command is reported
+static int cmd_first_id = 0, cmd_per_dev = 0, cmd_devs = 0;
+static int cmd_devs_done = 0, cmd_devs_ok = 0;
+static uint32_t cmd_slowest_us = 0;
+
+// --- Device picker: live devices from the last table snapshot ---
+static struct xifi_device live[XIFI_MAX_DEVICES];
+static int live_n = 0;
+static uint32_t target_ip = 0;       // picked device, 0 = all live devices
+
+// --- Network stats overlay (hold BACK, press START; BACK+Y saves) ---
+static int stats_open = 0;
+static char stats_lines[STATS_MAX_LINES][NET_STATS_LINE];
+static int stats_n = 0;
+static uint32_t stats_next = 0;      // next refresh, SDL_GetTicks()
+static SDL_Rect stats_rect = {0};
+
+static void SetCmdMsg(const char* text, SDL_Color col, uint32_t show_ms) {
+    snprintf(cmd_msg, sizeof(cmd_msg), "%s", text);
+    cmd_msg_col = col;
+    cmd_msg_until = show_ms ? SDL_GetTicks() + show_ms : 0;
+    cmd_msg_changed = 1;
+}
+
+// Hands commands to the network reactor for the picked device, or all live
+// devices at once; results come back through CmdQueue_PollResult().
+static void QueueCmds(const struct xifi_cmd* cmds, int n) {
+    char ipbuf[XIFI_MAX_DEVICES][32];
+    const char* ips[XIFI_MAX_DEVICES];
+    int n_ips = 0;
+    for (int i = 0; i < live_n; i++) {
+        if (target_ip && live[i].ipv4 != target_ip) continue;
+        ips[n_ips] = XiFi_FormatIP(live[i].ipv4, ipbuf[n_ips], sizeof(ipbuf[n_ips]));
+        n_ips++;
+    }
+    if (n_ips == 0) ips[n_ips++] = XiFi_GetIP();   // fails fast as offline
+
+    int id = CmdQueue_PushFanout(ips, n_ips, cmds, n);
+    if (id) {
+        cmd_first_id = id - (n_ips * n - 1);
+        cmd_per_dev = n;
+        cmd_devs = n_ips;
+        cmd_devs_done = cmd_devs_ok = 0;
+        cmd_slowest_us = 0;
+        char msg[48];
+        if (n_ips > 1) snprintf(msg, sizeof(msg), "Sending to %d XiFi...", n_ips);
+        else snprintf(msg, sizeof(msg), "Sending...");
+        SetCmdMsg(msg, (SDL_Color){200,200,200,255}, 0);
+    } else {
+        SetCmdMsg("Command queue full", (SDL_Color){255,0,0,255}, 2000);
+    }
+}
+
+// Picker text: the lone IP, the picked device, or "All"
+static void TargetText(char* buf, int len) {
+    char ip[32];
+    if (live_n <= 1) {
+        snprintf(buf, len, "%s", live_n ? XiFi_FormatIP(live[0].ipv4, ip, sizeof(ip)) : "");
         return;
     }
-    size_t r = fread(stream, 1, len, audio_file);
-    if (r < (size_t)len) {
-        fseek(audio_file, 44, SEEK_SET);
-        fread(stream + r, 1, len - r, audio_file);
+    for (int i = 0; i < live_n; i++) {
+        if (live[i].ipv4 == target_ip) {
+            snprintf(buf, len, "%s [%d/%d]  LB/RB", XiFi_FormatIP(target_ip, ip, sizeof(ip)),
+                     i + 1, live_n);
+            return;
+        }
     }
-    int16_t* samples = (int16_t*)stream;
-    int count = len / sizeof(int16_t);
-    for (int i = 0; i < count; i++) {
-        float v = samples[i] * MUSIC_VOLUME;
-        if (v < -32768.f) v = -32768.f;
-        else if (v > 32767.f) v = 32767.f;
-        samples[i] = (int16_t)v;
+    snprintf(buf, len, "All %d units  LB/RB", live_n);
+}
+
+// Step the picker through All, device 1 .. device n
+static void CycleTarget(int dir) {
+    if (live_n <= 1) return;
+    int cur = 0;   // 0 = All, i+1 = live[i]
+    for (int i = 0; i < live_n; i++) {
+        if (live[i].ipv4 == target_ip) cur = i + 1;
     }
+    cur = (cur + dir + live_n + 1) % (live_n + 1);
+    target_ip = cur ? live[cur - 1].ipv4 : 0;
 }
 
-// --- Draws an octagon border ---
-static void DrawOct(SDL_Renderer *r, SDL_Rect rc, int m, SDL_Color c) {
-    int l = rc.x - m, t = rc.y - m;
-    int w = rc.w + 2*m, h = rc.h + 2*m;
-    SDL_Point pts[9] = {
-        {l+m,    t}, {l+w-m,  t},
-        {l+w,    t+m}, {l+w,    t+h-m},
-        {l+w-m,  t+h}, {l+m,    t+h},
-        {l,      t+h-m}, {l,      t+m},
-        {l+m,    t}
-    };
-    SDL_SetRenderDrawColor(r, c.r, c.g, c.b, c.a);
-    SDL_RenderDrawLines(r, pts, 9);
+// Only the latest job is shown, once per device's last command
+static void ShowCmdResult(int id, const struct send_result* res) {
+    int rel = id - cmd_first_id;
+    if (!cmd_devs || rel < 0 || rel >= cmd_devs * cmd_per_dev || rel % cmd_per_dev != cmd_per_dev - 1)
+        return;
+    char msg[48];
+    cmd_devs_done++;
+    cmd_devs_ok += send_result_ok(res);
+    if (res->latency_us > cmd_slowest_us) cmd_slowest_us = res->latency_us;
+    if (cmd_devs == 1) {
+        if (res->status != SEND_OK)
+            snprintf(msg, sizeof(msg), "Command failed: %s", send_status_str(res->status));
+        else if (!send_result_ok(res))
+            snprintf(msg, sizeof(msg), "Rejected by XiFi (HTTP %d)", res->http_status);
+        else
+            snprintf(msg, sizeof(msg), "Command OK (%u ms)", (unsigned)(res->latency_us / 1000));
+        SetCmdMsg(msg, send_result_ok(res) ? (SDL_Color){0,255,0,255}
+                                           : (SDL_Color){255,0,0,255}, 2000);
+    } else if (cmd_devs_done == cmd_devs) {
+        snprintf(msg, sizeof(msg), "Applied to %d/%d XiFi (%u ms)",
+                 cmd_devs_ok, cmd_devs, (unsigned)(cmd_slowest_us / 1000));
+        SetCmdMsg(msg, cmd_devs_ok == cmd_devs ? (SDL_Color){0,255,0,255}
+                                               : (SDL_Color){255,0,0,255}, 2000);
+    }
 }
 
-// --- Fills the inside of an octagon ---
-static void FillOct(SDL_Renderer *r, SDL_Rect rc, int m, SDL_Color c) {
-    int l = rc.x - m, t = rc.y - m;
-    int w = rc.w + 2*m, h = rc.h + 2*m;
-    SDL_Point pts[8] = {
-        {l+m,    t}, {l+w-m,  t}, {l+w,    t+m}, {l+w,    t+h-m},
-        {l+w-m,  t+h}, {l+m,    t+h}, {l,      t+h-m}, {l,      t+m}
-    };
-    SDL_SetRenderDrawColor(r, c.r, c.g, c.b, c.a);
-    for (int y = t; y <= t + h; y++) {
-        int x[8], n = 0;
-        for (int i = 0; i < 8; i++) {
-            SDL_Point p1 = pts[i];
-            SDL_Point p2 = pts[(i+1)%8];
-            if ((y >= p1.y && y < p2.y) || (y >= p2.y && y < p1.y)) {
-                int dy = p2.y - p1.y;
-                if (dy != 0) {
-                    int ix = p1.x + (int)((float)(y - p1.y) * (float)(p2.x - p1.x) / (float)dy);
-                    x[n++] = ix;
-                }
-            }
-        }
-        if (n < 2) continue;
-        if (x[0] > x[1]) { int tmp = x[0]; x[0] = x[1]; x[1] = tmp; }
-        SDL_RenderDrawLine(r, x[0], y, x[1], y);
+// Re-read the stats and size the overlay around them (damages old and new area)
+static void RefreshNetStats(int screen_h) {
+    damage_add(&stats_rect);
+    stats_n = net_stats_format(stats_lines, STATS_MAX_LINES - 1);
+    struct audio_stats as;
+    AudioStream_GetStats(&as);
+    snprintf(stats_lines[stats_n++], NET_STATS_LINE,
+             "Audio %u/%u ms buffered  underruns %u  slowest read %u ms",
+             (unsigned)as.buffered_ms, (unsigned)as.capacity_ms, (unsigned)as.underruns,
+             (unsigned)(as.slowest_read_us / 1000));
+    int cell = kybd_glyph_cell(screen_h), widest = 0;
+    for (int i = 0; i < stats_n; i++) {
+        int len = (int)strlen(stats_lines[i]);
+        if (len > widest) widest = len;
+    }
+    stats_rect = (SDL_Rect){ cell, cell, (widest + 2) * cell, (stats_n + 1) * (cell + cell / 4) + cell };
+    damage_add(&stats_rect);
+    stats_next = SDL_GetTicks() + STATS_REFRESH_MS;
+}
+
+static void DrawNetStats(SDL_Renderer* r, int screen_h) {
+    int cell = kybd_glyph_cell(screen_h), pitch = cell + cell / 4;
+    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(r, 0, 0, 0, 200);
+    SDL_RenderFillRect(r, &stats_rect);
+    SDL_SetRenderDrawColor(r, 80, 255, 100, 255);
+    SDL_RenderDrawRect(r, &stats_rect);
+    int y = stats_rect.y + cell;
+    for (int i = 0; i < stats_n; i++, y += pitch) {
+        SDL_Color col = i == 3 ? (SDL_Color){80,255,100,255} : (SDL_Color){255,255,255,255};
+        kybd_draw_text(r, screen_h, stats_lines[i], stats_rect.x + cell, y, col);
     }
 }
 
+static void SaveNetStats(void) {
+    char path[256];
+    if (net_stats_dump(plat_data_path(STATS_FILE, path, sizeof(path))))
+        SetCmdMsg("Stats saved to " STATS_FILE, (SDL_Color){0,255,0,255}, 2000);
+    else
+        SetCmdMsg("Could not save stats", (SDL_Color){255,0,0,255}, 2000);
+}
+
+// Cold-start record for comparing the asset pack with the media files per
+// video mode; boots that can't write (read-only media) are only logged
+static void SaveBootTimes(uint32_t first_frame_ms, uint32_t interactive_ms) {
+    char path[256];
+    FILE* f = fopen(plat_data_path(BOOT_TIMES_FILE, path, sizeof(path)), "a");
+    if (!f) return;
+    fprintf(f, "%dx%d %s first_frame=%u assets=%u interactive=%u\n", screen_width, screen_height,
+            BootLoad_UsedPack() ? "pack" : "media", (unsigned)first_frame_ms,
+            (unsigned)BootLoad_Millis(), (unsigned)interactive_ms);
+    fclose(f);
+}
+
+static void QueueCmd(const char* cmd_hex) {
+    struct xifi_cmd c = { cmd_hex, NULL };
+    QueueCmds(&c, 1);
+}
+
 // ---- SCALED COORDINATE HELPERS ----
 #define SCALEX(x) ((int)((float)(x) * screen_width / (float)SCREEN_WIDTH_DEF))
 #define SCALEY(y) ((int)((float)(y) * screen_height / (float)SCREEN_HEIGHT_DEF))
 
+// --- Marks everything a menu button can touch: octagon, border and shadow ---
+static void DamageButton(SDL_Rect rc, int m) {
+    SDL_Rect r = { rc.x - m, rc.y - m,
+                   rc.w + 2*m + SCALEX(8) + 1, rc.h + 2*m + SCALEY(8) + 1 };
+    damage_add(&r);
+}
+
+// Splash line under the menu while the loader thread is still busy; built
+// from the keyboard's glyph atlas, so it needs no files
+static void DrawSplash(SDL_Renderer* r) {
+    static const char text[] = "Loading...";
+    int cell = kybd_glyph_cell(screen_height);
+    int x = (screen_width - (int)(sizeof(text) - 1) * cell) / 2;
+    kybd_draw_text(r, screen_height, text, x, SCALEY(620), (SDL_Color){200,200,200,255});
+}
+
 int main(void) {
+    uint32_t bootStart = SDL_GetTicks();
+    bool bootLogged = false;
+
     // Set texture filtering to linear for smooth scaling of images/logos
     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1");
 
     // --- VIDEO MODE PROBE ---
-    struct { int w, h, mode; } modes[] = {
-        {1280, 720, REFRESH_DEFAULT},
-        {720, 480, REFRESH_DEFAULT},
-        {640, 480, REFRESH_DEFAULT},
-    };
-    bool found = false;
-    for (size_t i = 0; i < sizeof(modes)/sizeof(modes[0]); ++i) {
-        if (XVideoSetMode(modes[i].w, modes[i].h, 32, modes[i].mode) == TRUE) {
-            screen_width = modes[i].w;
-            screen_height = modes[i].h;
-            found = true;
-            break;
-        }
-    }
-    if (!found) return 0;
+    if (!plat_video_init(&screen_width, &screen_height)) return 0;
+    damage_init(screen_width, screen_height);
 
     SDL_SetMainReady();
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER) != 0)
@@ -119,28 +256,6 @@ int main(void) {
     if ((IMG_Init(IMG_INIT_JPG | IMG_INIT_PNG) & (IMG_INIT_JPG | IMG_INIT_PNG))
         != (IMG_INIT_JPG | IMG_INIT_PNG)) return 0;
 
-    if (nxNetInit(NULL) != 0) {
-        debugPrint("Network initialization failed!\n");
-        return 1;
-    }
-
-    XiFi_StartDetectionThread(2000);
-
-    // --- AUDIO SETUP ---
-    audio_file = fopen("D:\\media\\bg\\bg.wav", "rb");
-    if (!audio_file) return 0;
-    static char buf[64*1024];
-    setvbuf(audio_file, buf, _IOFBF, sizeof(buf));
-    fseek(audio_file, 44, SEEK_SET);
-    SDL_AudioSpec spec = {0};
-    spec.freq     = 44100;
-    spec.format   = AUDIO_S16LSB;
-    spec.channels = 2;
-    spec.samples  = 2048;
-    spec.callback = AudioCallback;
-    if (SDL_OpenAudio(&spec, NULL) < 0) return 0;
-    SDL_PauseAudio(0);
-
     // --- CONTROLLER SETUP ---
     SDL_GameController* controller = NULL;
     for (int i = 0; i < SDL_NumJoysticks(); i++) {
@@ -164,102 +279,207 @@ int main(void) {
         return 0;
     }
 
-    SDL_Surface* bgSurface = IMG_Load("D:\\media\\img\\background.jpg");
-    SDL_Texture* bgTexture = bgSurface
-        ? SDL_CreateTextureFromSurface(renderer, bgSurface)
-        : NULL;
-    if (bgSurface) SDL_FreeSurface(bgSurface);
-
-    // --- FONT SIZES ---
-    int font48_sz = screen_height/15;
-    int font24_sz = screen_height/30;
-    int font28_sz = screen_height/25;
-
-    TTF_Font* font48 = TTF_OpenFont("D:\\media\\font\\font.ttf", font48_sz);
-    TTF_Font* font24 = TTF_OpenFont("D:\\media\\font\\font.ttf", font24_sz);
-    TTF_Font* font28 = TTF_OpenFont("D:\\media\\font\\font.ttf", font28_sz);
-
-    SDL_Texture* titleTex = NULL;
-    SDL_Rect titleR = {0};
-    if (font48) {
-        SDL_Surface* ts = TTF_RenderText_Blended(
-            font48, "XiFi Configuration", (SDL_Color){255,255,255,255});
-        titleTex = SDL_CreateTextureFromSurface(renderer, ts);
-        titleR = (SDL_Rect){ (screen_width - ts->w)/2, SCALEY(50), ts->w, ts->h };
-        SDL_FreeSurface(ts);
+    // --- SPLASH: on screen before any file or network work ---
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    DrawSplash(renderer);
+    SDL_RenderPresent(renderer);
+    uint32_t firstFrameMs = SDL_GetTicks() - bootStart;
+    plat_log("Boot: first frame at %u ms\n", (unsigned)firstFrameMs);
+
+#ifdef XIFI_BENCH
+    kybd_bench(renderer, screen_width, screen_height, 200);
+    gain_bench(2000);
+#endif
+
+    // --- STARTUP ASSETS: decoded by the loader thread, uploaded below as
+    // they arrive. Everything starts out NULL and is drawn once it exists.
+    // The background comes out in the window's pixel format, so each
+    // frame's copy is 1:1 with no scaling, filtering or conversion.
+    Uint32 screenFormat = SDL_GetWindowPixelFormat(window);
+    if (screenFormat == SDL_PIXELFORMAT_UNKNOWN) screenFormat = SDL_PIXELFORMAT_ARGB8888;
+    BootLoad_Start(screen_width, screen_height, screenFormat);
+    bool booting = true;
+    struct boot_fonts bootFonts = {0};
+    TTF_Font* font24 = NULL;   // body font, set once the loader is done with it
+    SDL_Texture *bgTexture = NULL, *titleTex = NULL, *dcT = NULL, *trT = NULL;
+    SDL_Texture *ep = NULL, *eb = NULL, *ep2 = NULL, *xiT = NULL;
+    SDL_Texture* aboutT[UI_ABOUT_LINES] = {0};
+    SDL_Rect titleR = {0}, epr = {0}, ebr = {0}, ep2r = {0};
+    SDL_Rect aboutR[UI_ABOUT_LINES] = {{0}};
+    SDL_Rect xiR={0}, stR={0}, ipR={0}, cmdR={0};
+    // What sits behind an open About page or keyboard, composited once (see
+    // the render loop). NULL if the renderer has no render targets; the
+    // backdrop is then drawn directly, as before.
+    SDL_Texture* modalBase = SDL_CreateTexture(renderer, screenFormat, SDL_TEXTUREACCESS_TARGET,
+                                               screen_width, screen_height);
+    if (modalBase) SDL_SetTextureBlendMode(modalBase, SDL_BLENDMODE_NONE);
+    int baseValid = 0;
+
+    // --- NETWORK AND MUSIC, while the loader reads ---
+    if (!plat_net_init()) {
+        plat_fatal("Network initialization failed!\n");
+        goto cleanup;
     }
-
-    // --- BOTTOM "PRESS B TO EXIT" LABEL ---
-    SDL_Texture *ep=NULL, *eb=NULL, *ep2=NULL;
-    SDL_Rect epr={0}, ebr={0}, ep2r={0};
-    if (font24) {
-        SDL_Color white={200,200,200,255}, red={255,0,0,255};
-        SDL_Surface* s1 = TTF_RenderText_Blended(font24, "Press ", white);
-        ep = SDL_CreateTextureFromSurface(renderer, s1);
-        epr = (SDL_Rect){0,0,s1->w,s1->h}; SDL_FreeSurface(s1);
-        SDL_Surface* s2 = TTF_RenderText_Blended(font24, "B", red);
-        eb = SDL_CreateTextureFromSurface(renderer, s2);
-        ebr = (SDL_Rect){0,0,s2->w,s2->h}; SDL_FreeSurface(s2);
-        SDL_Surface* s3 = TTF_RenderText_Blended(font24, " to exit", white);
-        ep2 = SDL_CreateTextureFromSurface(renderer, s3);
-        ep2r = (SDL_Rect){0,0,s3->w,s3->h}; SDL_FreeSurface(s3);
-        int totalW = epr.w + ebr.w + ep2r.w;
-        epr.x = screen_width - totalW - SCALEX(20); epr.y = screen_height - epr.h - SCALEY(20);
-        ebr.x = epr.x + epr.w;      ebr.y = epr.y;
-        ep2r.x= ebr.x + ebr.w;      ep2r.y= epr.y;
+    // Heartbeat every second; absent after 3 misses
+    if (!XiFi_StartDetection(1000) || !CmdQueue_Start()) {
+        plat_fatal("Network thread could not start!\n");
+        goto cleanup;
     }
 
-    // --- XIFI/STATUS/IP ---
-    SDL_Texture *xiT=NULL, *stT=NULL, *ipT=NULL;
-    SDL_Rect xiR={SCALEX(20),0,0,0}, stR={0}, ipR={0};
-    if (font24) {
-        SDL_Surface* sx = TTF_RenderText_Blended(
-            font24, "XiFi ", (SDL_Color){255,255,255,255});
-        xiT = SDL_CreateTextureFromSurface(renderer, sx);
-        xiR = (SDL_Rect){SCALEX(20), screen_height - sx->h - SCALEY(20), sx->w, sx->h};
-        SDL_FreeSurface(sx);
-    }
+    char path[256];
+    if (!AudioStream_Start(plat_asset_path("bg/bg.wav", path, sizeof(path)),
+                           AUDIO_SAMPLES, AUDIO_AHEAD_MS, MUSIC_VOLUME)) goto cleanup;
 
-    // --- MENU ITEMS ---
-    const char* items[MENU_ITEM_COUNT] = {
-        "Start XiFi Portal", "Clear WiFi Password", "Turn off OLED",
-        "Turn on OLED",      "Set Custom Status",   "Clear Custom Status",
-        "About"
-    };
-    SDL_Rect mrect[MENU_ITEM_COUNT];
+    // --- MENU ITEMS: each button appears once both of its labels are in ---
+    const char* const* items = ui_menu_items;
+    SDL_Rect mrect[MENU_ITEM_COUNT] = {{0}};
+    int menuParts[MENU_ITEM_COUNT] = {0};   // labels received, 2 = drawable
     int cx[2] = {screen_width/4, 3*screen_width/4};
     int ry[4] = {SCALEY(200),SCALEY(300),SCALEY(400),SCALEY(500)};
     int cw = SCALEX(400), ch = SCALEY(80);
-    for (int i = 0; i < MENU_ITEM_COUNT; i++) {
-        SDL_Surface* ms = TTF_RenderText_Blended(
-            font24, items[i], (SDL_Color){255,255,255,255});
-        int w = ms->w, h = ms->h; SDL_FreeSurface(ms);
-        int col = (i<6 ? i%2 : 0), row = (i<6 ? i/2 : 3);
-        int px = (i<6 ? cx[col]-cw/2 : screen_width/2-cw/2);
-        int py = ry[row] - ch/2;
-        mrect[i] = (SDL_Rect){ px+(cw-w)/2, py+(ch-h)/2, w, h };
-    }
+    SDL_Color itemCol[2] = { {255,255,255,255}, {0,0,0,255} }; // enabled, disabled
+    SDL_Color octSel = {0,220,0,255}, octFill = {36,36,36,255}, octBorder = {80,255,100,255};
     int selected = 0, aboutOpen = 0, kybdOpen = 0;
-    char kb_text[33] = {0};
 
-    SDL_Texture *dcT=NULL, *trT=NULL;
-    if (font28) {
-        SDL_Surface* d = IMG_Load("D:\\media\\img\\DC.png");
-        dcT = d ? SDL_CreateTextureFromSurface(renderer, d) : NULL; if(d)SDL_FreeSurface(d);
-        SDL_Surface* t = IMG_Load("D:\\media\\img\\TR.png");
-        trT = t ? SDL_CreateTextureFromSurface(renderer, t) : NULL; if(t)SDL_FreeSurface(t);
-    }
+    // Status/IP text is only recomputed when detection state changes
+    SDL_Color statusOk = {0,255,0,255}, statusBad = {255,0,0,255}, ipCol = {255,255,255,255};
+    struct xifi_state xs = {0};         // snapshot the screen currently shows
+    uint32_t shownGen = ~0u;
+    int targetChanged = 0;
+    char shownIP[48] = {0};
+    const char* statusText = "Not Detected";
+    SDL_Color statusCol = statusBad;
+    char kb_text[33] = {0};
 
     // --- MENU FAST KEY REPEAT ---
     static int menu_repeat_dir = 0;
     static uint32_t menu_repeat_start = 0, menu_repeat_last = 0;
+    int triggerHeld[2] = {0, 0};   // LT, RT
 
     SDL_Event event;
+    damage_add_all(); // first frame draws everything
     while (1) {
+        int prevSelected = selected, prevAbout = aboutOpen, prevKybd = kybdOpen;
+
+        // ---- STARTUP ASSETS: upload whatever the loader has finished ----
+        struct boot_msg bm;
+        while (booting && BootLoad_Poll(&bm)) {
+            baseValid = 0;
+            if (bm.kind == BOOT_FONTS) {
+                BootLoad_Fonts(&bootFonts);
+                continue;
+            }
+            if (bm.kind == BOOT_DONE) {
+                // The loader is finished with the fonts, so labels that were
+                // never baked (IP, command feedback) can render from now on
+                BootLoad_Stop();
+                font24 = bootFonts.text;
+                booting = false;
+                targetChanged = 1;
+                cmd_msg_changed = 1;
+                damage_add_all();   // clears the splash line
+                continue;
+            }
+            const struct asset_item* a = BootLoad_Asset(bm.index);
+            int w = bm.surf->w, h = bm.surf->h;
+            SDL_Texture* t = img_texture(renderer, bm.surf);
+            SDL_FreeSurface(bm.surf);
+            if (!t) continue;
+            bool isBg = a->kind == ASSET_IMAGE && a->src == asset_source_path[ASRC_BACKGROUND];
+            SDL_SetTextureBlendMode(t, isBg ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
+
+            SDL_Texture** slot = NULL;
+            SDL_Rect* rc = NULL;
+            if (a->kind == ASSET_IMAGE) {
+                slot = isBg ? &bgTexture : a->src == asset_source_path[ASRC_DC] ? &dcT : &trT;
+            } else if (a->font_px == FONT_TITLE_PX(screen_height)) {
+                slot = &titleTex; rc = &titleR;
+            } else if (a->about_lines) {
+                // By line number: equal strings may be one literal, so the
+                // text pointer can't tell the lines apart. Lines with the
+                // same text share the first one's texture.
+                for (int i = 0; i < UI_ABOUT_LINES; i++) {
+                    if (!(a->about_lines & (1u << i))) continue;
+                    if (!slot) { slot = &aboutT[i]; rc = &aboutR[i]; continue; }
+                    aboutT[i] = t;
+                    aboutR[i].w = w;
+                    aboutR[i].h = h;
+                }
+            } else if (!strcmp(a->src, "Press "))   { slot = &ep;  rc = &epr; }
+            else if (!strcmp(a->src, "B"))        { slot = &eb;  rc = &ebr; }
+            else if (!strcmp(a->src, " to exit")) { slot = &ep2; rc = &ep2r; }
+            else if (!strcmp(a->src, "XiFi "))    { slot = &xiT; rc = &xiR; }
+
+            if (!slot) {
+                // Menu and status words: into the label cache under the body
+                // font, where the label_get lookups below will find them
+                label_adopt(bootFonts.text, a->src, a->col, t, w, h);
+                for (int i = 0; i < MENU_ITEM_COUNT; i++) {
+                    if (a->src != items[i]) continue;
+                    int col = (i<6 ? i%2 : 0), row = (i<6 ? i/2 : 3);
+                    int px = (i<6 ? cx[col]-cw/2 : screen_width/2-cw/2);
+                    int py = ry[row] - ch/2;
+                    mrect[i] = (SDL_Rect){ px+(cw-w)/2, py+(ch-h)/2, w, h };
+                    if (++menuParts[i] == 2) DamageButton(mrect[i], SCALEY(12));
+                }
+                continue;
+            }
+            *slot = t;
+            if (rc) {
+                rc->w = w;
+                rc->h = h;
+            }
+            // Re-place the fixed labels around what has arrived so far
+            titleR.x = (screen_width - titleR.w)/2;
+            titleR.y = SCALEY(50);
+            int exitH = SDL_max(epr.h, SDL_max(ebr.h, ep2r.h));
+            epr.x = screen_width - (epr.w + ebr.w + ep2r.w) - SCALEX(20);
+            epr.y = screen_height - exitH - SCALEY(20);
+            ebr.x = epr.x + epr.w;      ebr.y = epr.y;
+            ep2r.x= ebr.x + ebr.w;      ep2r.y= epr.y;
+            xiR.x = SCALEX(20);
+            xiR.y = screen_height - xiR.h - SCALEY(20);
+            for (int i = 0; i < UI_ABOUT_LINES; i++) {
+                aboutR[i].x = (screen_width - aboutR[i].w) / 2;
+                aboutR[i].y = SCALEY(160) + i * SCALEY(40);
+            }
+            damage_add_all();
+        }
+
+        // ---- COMMAND RESULTS FROM THE NETWORK REACTOR ----
+        int doneId;
+        struct send_result doneRes;
+        while (CmdQueue_PollResult(&doneId, &doneRes)) ShowCmdResult(doneId, &doneRes);
+
         // ---- MAIN EVENT LOOP ----
         while (SDL_PollEvent(&event)) {
+            // Debug chords: hold BACK, then START toggles the stats overlay
+            // and Y saves the stats to a file
+            if (event.type == SDL_CONTROLLERBUTTONDOWN && controller &&
+                SDL_GameControllerGetButton(controller, SDL_CONTROLLER_BUTTON_BACK) &&
+                (event.cbutton.button == SDL_CONTROLLER_BUTTON_START ||
+                 event.cbutton.button == SDL_CONTROLLER_BUTTON_Y)) {
+                if (event.cbutton.button == SDL_CONTROLLER_BUTTON_Y) {
+                    SaveNetStats();
+                } else {
+                    stats_open = !stats_open;
+                    damage_add(&stats_rect);
+                    if (stats_open) RefreshNetStats(screen_height);
+                }
+                continue;
+            }
             if (kybdOpen) {
                 int ret = kybd_handle_event(&event, kb_text, sizeof(kb_text));
+                if (ret == KYBD_DONE && kb_text[0]) {
+                    // Macro: OLED on, clear the old status, set the new one
+                    // (0110 + ASCII as hex). Sent as one batch request when
+                    // the XiFi supports it, otherwise pipelined.
+                    char hex[72];
+                    ascii_to_hex(kb_text, hex, sizeof(hex));
+                    struct xifi_cmd seq[3] = { {"010F", NULL}, {"0111", NULL}, {"0110", hex} };
+                    QueueCmds(seq, 3);
+                }
                 if (ret == KYBD_DONE || ret == KYBD_CANCELED) {
                     // Always reset keyboard state/buffer
                     kybdOpen = 0;
@@ -268,9 +488,28 @@ int main(void) {
                 continue;
             }
 
+            // Music volume: LT/RT step it down/up once per pull
+            if (event.type == SDL_CONTROLLERAXISMOTION &&
+                (event.caxis.axis == SDL_CONTROLLER_AXIS_TRIGGERLEFT ||
+                 event.caxis.axis == SDL_CONTROLLER_AXIS_TRIGGERRIGHT)) {
+                int up = event.caxis.axis == SDL_CONTROLLER_AXIS_TRIGGERRIGHT;
+                int pulled = event.caxis.value > (triggerHeld[up] ? TRIGGER_PRESS / 2 : TRIGGER_PRESS);
+                if (pulled && !triggerHeld[up]) {
+                    int vol = AudioStream_GetVolume() + (up ? VOLUME_STEP : -VOLUME_STEP);
+                    if (vol < 0) vol = 0;
+                    if (vol > AUDIO_VOLUME_MAX) vol = AUDIO_VOLUME_MAX;
+                    AudioStream_SetVolume(vol);
+                    char msg[32];
+                    snprintf(msg, sizeof(msg), "Music volume %d%%", vol);
+                    SetCmdMsg(msg, (SDL_Color){255,255,255,255}, 1500);
+                }
+                triggerHeld[up] = pulled;
+                continue;
+            }
+
             if (event.type == SDL_CONTROLLERBUTTONDOWN) {
                 int b = event.cbutton.button;
-                bool xifiPresent = XiFi_IsPresent();
+                bool xifiPresent = xs.present;   // match what is on screen
                 bool isDisabled = !xifiPresent && selected != 6; // 6 = About
                 if (aboutOpen) {
                     if (b == SDL_CONTROLLER_BUTTON_B) aboutOpen = 0;
@@ -282,26 +521,32 @@ int main(void) {
                             if (isDisabled)
                                 break;
                             switch (selected) {
-                                case 0: send_cmd(XiFi_GetIP(), "0101", NULL); break;
-                                case 1: send_cmd(XiFi_GetIP(), "0102", NULL); break;
-                                case 2: send_cmd(XiFi_GetIP(), "010E", NULL); break;
-                                case 3: send_cmd(XiFi_GetIP(), "010F", NULL); break;
+                                case 0: QueueCmd("0101"); break;
+                                case 1: QueueCmd("0102"); break;
+                                case 2: QueueCmd("010E"); break;
+                                case 3: QueueCmd("010F"); break;
                                 case 4:
                                     if (xifiPresent) {
                                         kybdOpen = 1;     // always re-enable overlay
                                         kb_text[0] = 0;   // always clear buffer on entry
+                                        kybd_init(kb_text, sizeof(kb_text));
                                     }
                                     break;
-                                case 5: send_cmd(XiFi_GetIP(), "0111", NULL); break;
+                                case 5: QueueCmd("0111"); break;
                                 case 6: aboutOpen = 1; break;
                             }
                             break;
                         case SDL_CONTROLLER_BUTTON_X:
                             if (!xifiPresent) break;
-                            send_cmd(XiFi_GetIP(), "0112", NULL); break;
+                            QueueCmd("0112"); break;
                         case SDL_CONTROLLER_BUTTON_Y:
                             if (!xifiPresent) break;
-                            send_cmd(XiFi_GetIP(), "0113", NULL); break;
+                            QueueCmd("0113"); break;
+                        case SDL_CONTROLLER_BUTTON_LEFTSHOULDER:
+                        case SDL_CONTROLLER_BUTTON_RIGHTSHOULDER:
+                            CycleTarget(b == SDL_CONTROLLER_BUTTON_LEFTSHOULDER ? -1 : 1);
+                            targetChanged = 1;
+                            break;
                         case SDL_CONTROLLER_BUTTON_DPAD_UP:
                             selected = (selected + 5) % MENU_ITEM_COUNT;
                             if (selected == 6) selected = 4;
@@ -366,225 +611,282 @@ int main(void) {
         // ---- FAST KEYBOARD REPEAT FOR ONSCREEN KEYBOARD ----
         if (kybdOpen) kybd_update_repeat();
 
-        // -- STATUS AND IP TEXTURES --
-        if (stT) SDL_DestroyTexture(stT);
-        if (ipT) SDL_DestroyTexture(ipT);
-        const char* statusText = XiFi_IsPresent() ? "Detected" : "Not Detected";
-        SDL_Color   statusCol  = XiFi_IsPresent()
-                                 ? (SDL_Color){0,255,0,255}
-                                 : (SDL_Color){255,0,0,255};
-        SDL_Surface* ss = TTF_RenderText_Blended(font24, statusText, statusCol);
-        stT = SDL_CreateTextureFromSurface(renderer, ss);
-        stR = (SDL_Rect){ xiR.x + xiR.w, xiR.y, ss->w, ss->h };
-        SDL_FreeSurface(ss);
-
-        const char* show_ip = XiFi_IsPresent() ? XiFi_GetIP() : "";
-        if (show_ip[0]) {
-            SDL_Surface* ips = TTF_RenderText_Blended(font24, show_ip, (SDL_Color){255,255,255,255});
-            ipT = SDL_CreateTextureFromSurface(renderer, ips);
-            ipR = (SDL_Rect){ xiR.x + xiR.w + stR.w + SCALEX(10), xiR.y, ips->w, ips->h };
-            SDL_FreeSurface(ips);
-        } else {
-            ipT = NULL;
+        // ---- DAMAGE FROM INPUT ----
+        if (aboutOpen != prevAbout || kybdOpen != prevKybd) {
+            baseValid = 0;
+            damage_add_all();
+        } else if (selected != prevSelected && !aboutOpen && !kybdOpen) {
+            DamageButton(mrect[prevSelected], SCALEY(12));
+            DamageButton(mrect[selected], SCALEY(12));
+        }
+        if (kybd_consume_dirty() && kybdOpen) {
+            // Layout switches resize the overlay, so cover the modal panel too
+            SDL_Rect kb;
+            kybd_get_bounds(screen_width, screen_height, &kb);
+            damage_add(&kb);
+            int panel_w = SCALEX(960), panel_h = SCALEY(420);
+            SDL_Rect panel = { (screen_width - panel_w) / 2, (screen_height - panel_h) / 2,
+                               panel_w + SCALEX(14) + 1, panel_h + SCALEY(14) + 1 };
+            damage_add(&panel);
         }
 
-        // -- Render loop --
-        SDL_RenderClear(renderer);
-        if (bgTexture)    SDL_RenderCopy(renderer, bgTexture, NULL, NULL);
-        if (titleTex)     SDL_RenderCopy(renderer, titleTex,   NULL, &titleR);
-
-        // --- Menu and overlay layering ---
-        bool xifiPresent = XiFi_IsPresent();
-        // Draw the menu and highlights FIRST (always visible, even when overlay is open)
-        if (!aboutOpen && !kybdOpen) {
-            for (int i = 0; i < MENU_ITEM_COUNT; i++) {
-                SDL_Rect rect = mrect[i];
-                SDL_Rect shadow = rect;
-                shadow.x += SCALEX(8); shadow.y += SCALEY(8);
-
-                // Draw drop shadow
-                SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 80);
-                SDL_RenderFillRect(renderer, &shadow);
-
-                // Draw filled octagon for highlight or gray
-                if (i == selected) {
-                    FillOct(renderer, rect, SCALEY(12), (SDL_Color){0,220,0,255});
-                } else {
-                    FillOct(renderer, rect, SCALEY(12), (SDL_Color){36,36,36,255});
-                }
-
-                // Draw octagonal border
-                SDL_SetRenderDrawColor(renderer, 80, 255, 100, 255);
-                DrawOct(renderer, rect, SCALEY(12), (SDL_Color){80, 255, 100, 255});
-
-                // Disabled state: all except About (6) are disabled if not present
-                bool isDisabled = !xifiPresent && i != 6;
-                SDL_Color textColor = isDisabled
-                    ? (SDL_Color){0,0,0,255}
-                    : (SDL_Color){255,255,255,255};
-
-                // Draw menu text centered
-                SDL_Surface* ms = TTF_RenderText_Blended(
-                    font24, items[i], textColor);
-                SDL_Texture* tx = SDL_CreateTextureFromSurface(renderer, ms);
-                SDL_Rect textRect = rect;
-                textRect.x += (rect.w - ms->w) / 2;
-                textRect.y += (rect.h - ms->h) / 2;
-                textRect.w = ms->w;
-                textRect.h = ms->h;
-                SDL_FreeSurface(ms);
-                SDL_RenderCopy(renderer, tx, NULL, &textRect);
-                SDL_DestroyTexture(tx);
-            }
-        } else {
-            // Draw the menu as background (NO highlight), About/keyboard overlay on top
-            for (int i = 0; i < MENU_ITEM_COUNT; i++) {
-                SDL_Rect rect = mrect[i];
-
-                // Draw menu background (gray oct)
-                FillOct(renderer, rect, SCALEY(12), (SDL_Color){36,36,36,255});
-                // Octagonal border
-                SDL_SetRenderDrawColor(renderer, 80, 255, 100, 255);
-                DrawOct(renderer, rect, SCALEY(12), (SDL_Color){80, 255, 100, 255});
-
-                // Disabled state: all except About (6) are disabled if not present
-                bool isDisabled = !xifiPresent && i != 6;
-                SDL_Color textColor = isDisabled
-                    ? (SDL_Color){0,0,0,255}
-                    : (SDL_Color){255,255,255,255};
-
-                // Draw menu text centered
-                SDL_Surface* ms = TTF_RenderText_Blended(
-                    font24, items[i], textColor);
-                SDL_Texture* tx = SDL_CreateTextureFromSurface(renderer, ms);
-                SDL_Rect textRect = rect;
-                textRect.x += (rect.w - ms->w) / 2;
-                textRect.y += (rect.h - ms->h) / 2;
-                textRect.w = ms->w;
-                textRect.h = ms->h;
-                SDL_FreeSurface(ms);
-                SDL_RenderCopy(renderer, tx, NULL, &textRect);
-                SDL_DestroyTexture(tx);
+        // -- STATUS AND TARGET LABELS (only when detection state changes) --
+        XiFi_GetState(&xs);
+        int present = xs.present;
+        if (xs.generation != shownGen) {
+            // Device table moved: refresh the picker, dropping a vanished target
+            struct xifi_device all[XIFI_MAX_DEVICES];
+            int n = XiFi_GetDevices(all, XIFI_MAX_DEVICES);
+            int keep = 0;
+            live_n = 0;
+            for (int i = 0; i < n; i++) {
+                if (!all[i].present) continue;
+                live[live_n++] = all[i];
+                keep |= all[i].ipv4 == target_ip;
             }
+            if (!keep) target_ip = 0;
+            // Old status/IP area, every button (enabled state), then the new area
+            for (int i = 0; i < MENU_ITEM_COUNT; i++) DamageButton(mrect[i], SCALEY(12));
+            targetChanged = 1;
+            baseValid = 0;
+        }
+        if (targetChanged) {
+            damage_add(&stR);
+            damage_add(&ipR);
+            targetChanged = 0;
+            shownGen = xs.generation;
+            if (present) TargetText(shownIP, sizeof(shownIP));
+            else shownIP[0] = 0;
+            statusText = present ? "Detected" : "Not Detected";
+            statusCol  = present ? statusOk : statusBad;
+            const struct label* sl = label_get(renderer, font24, statusText, statusCol);
+            stR = (SDL_Rect){ xiR.x + xiR.w, xiR.y, sl ? sl->w : 0, sl ? sl->h : 0 };
+            // The IP changes at runtime: drawn from the glyph atlas, not cached as a label
+            ipR = (SDL_Rect){ stR.x + stR.w + SCALEX(10), xiR.y, 0, 0 };
+            font_cache_size(font24, shownIP, &ipR.w, &ipR.h);
+            damage_add(&stR);
+            damage_add(&ipR);
+        }
+        const struct label* stL = label_get(renderer, font24, statusText, statusCol);
+
+        // -- COMMAND FEEDBACK LINE --
+        if (cmd_msg_until && SDL_TICKS_PASSED(SDL_GetTicks(), cmd_msg_until)) {
+            SetCmdMsg("", cmd_msg_col, 0);
+        }
+        if (cmd_msg_changed) {
+            cmd_msg_changed = 0;
+            damage_add(&cmdR);
+            cmdR = (SDL_Rect){ 0, xiR.y, 0, 0 };
+            font_cache_size(font24, cmd_msg, &cmdR.w, &cmdR.h);
+            cmdR.x = (screen_width - cmdR.w) / 2;
+            damage_add(&cmdR);
+        }
+
+        // -- NETWORK STATS OVERLAY: live percentiles, refreshed twice a second --
+        if (stats_open && SDL_TICKS_PASSED(SDL_GetTicks(), stats_next)) RefreshNetStats(screen_height);
 
-            // Draw About overlay if open (drawn below keyboard if both open)
-            if (aboutOpen) {
-                SDL_Rect ov = {SCALEX(240), SCALEY(140), SCALEX(800), SCALEY(440)};
-                // Drop shadow for overlay
-                SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
-                SDL_Rect shadow = {ov.x + SCALEX(14), ov.y + SCALEY(14), ov.w, ov.h};
-                SDL_RenderFillRect(renderer, &shadow);
-
-                // About main panel -- SOLID BLACK
-                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-                SDL_RenderFillRect(renderer, &ov);
-
-                // Border
-                SDL_SetRenderDrawColor(renderer, 80, 255, 100, 255);
-                SDL_RenderDrawRect(renderer, &ov);
-
-                // About text content
-                const char* lines[] = {
-                    "XiFi Config", "",
-                    "Code by:", "Darkone83", "",
-                    "Music By:", "Darkone83"
-                };
-                for (int i = 0; i < 7; i++) {
-                    if (lines[i][0]) {
-                        SDL_Surface* ls = TTF_RenderText_Blended(
-                            font28, lines[i], (SDL_Color){255,255,255,255});
-                        SDL_Texture* lt = SDL_CreateTextureFromSurface(renderer, ls);
-                        SDL_Rect dr = {
-                            (screen_width - ls->w) / 2,
-                            SCALEY(160) + i * SCALEY(40),
-                            ls->w, ls->h
-                        };
-                        SDL_FreeSurface(ls);
-                        SDL_RenderCopy(renderer, lt, NULL, &dr);
-                        SDL_DestroyTexture(lt);
+        // -- Render loop: recomposite dirty regions only, skip idle frames --
+        if (damage_count() == 0) {
+            SDL_Delay(16);
+            continue;
+        }
+        // With a modal open, its backdrop (background, title, the menu
+        // without highlight, the About panel or the keyboard panel) is first
+        // composited into modalBase by one full-screen pass, d = -1. Each
+        // dirty rect then starts from a single copy of it, and only the
+        // keyboard and the footer are drawn live.
+        bool modal = aboutOpen || kybdOpen;
+        SDL_Rect fullScreen = { 0, 0, screen_width, screen_height };
+        for (int d = modal && modalBase && !baseValid ? -1 : 0; d < damage_count(); d++) {
+            bool toBase = d < 0;
+            const SDL_Rect* dirty = toBase ? &fullScreen : damage_get(d);
+            if (toBase) SDL_SetRenderTarget(renderer, modalBase);
+            SDL_RenderSetClipRect(renderer, dirty);
+            // Clear just this region (SDL_RenderClear ignores the clip rect)
+            SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+            SDL_RenderFillRect(renderer, dirty);
+            bool fromBase = modal && baseValid;
+            if (fromBase) SDL_RenderCopy(renderer, modalBase, dirty, dirty);
+            if (bgTexture && !fromBase) SDL_RenderCopy(renderer, bgTexture, NULL, NULL);
+            if (titleTex && !fromBase)  SDL_RenderCopy(renderer, titleTex,   NULL, &titleR);
+
+            // --- Menu and overlay layering ---
+            bool xifiPresent = present;
+            // Draw the menu and highlights FIRST (always visible, even when overlay is open)
+            // (labels looked up under the loader's body font: while booting
+            // only buttons whose baked labels are both in get drawn)
+            if (!aboutOpen && !kybdOpen) {
+                for (int i = 0; i < MENU_ITEM_COUNT; i++) {
+                    if (menuParts[i] < 2) continue;
+                    SDL_Rect rect = mrect[i];
+
+                    // Octagon for highlight or gray, with border and drop shadow
+                    oct_draw(renderer, rect, SCALEY(12), i == selected ? octSel : octFill,
+                             octBorder, SCALEX(8), SCALEY(8));
+
+                    // Disabled state: all except About (6) are disabled if not present
+                    bool isDisabled = !xifiPresent && i != 6;
+
+                    // Draw menu text centered
+                    const struct label* ml = label_get(renderer, bootFonts.text, items[i], itemCol[isDisabled]);
+                    if (ml) {
+                        SDL_Rect textRect = rect;
+                        textRect.x += (rect.w - ml->w) / 2;
+                        textRect.y += (rect.h - ml->h) / 2;
+                        textRect.w = ml->w;
+                        textRect.h = ml->h;
+                        SDL_RenderCopy(renderer, ml->tex, NULL, &textRect);
+                    }
+                }
+            } else if (!fromBase) {
+                // Draw the menu as background (NO highlight), About/keyboard overlay on top
+                for (int i = 0; i < MENU_ITEM_COUNT; i++) {
+                    if (menuParts[i] < 2) continue;
+                    SDL_Rect rect = mrect[i];
+
+                    // Draw menu background (gray oct with border, no shadow)
+                    oct_draw(renderer, rect, SCALEY(12), octFill, octBorder, 0, 0);
+
+                    // Disabled state: all except About (6) are disabled if not present
+                    bool isDisabled = !xifiPresent && i != 6;
+
+                    // Draw menu text centered
+                    const struct label* ml = label_get(renderer, bootFonts.text, items[i], itemCol[isDisabled]);
+                    if (ml) {
+                        SDL_Rect textRect = rect;
+                        textRect.x += (rect.w - ml->w) / 2;
+                        textRect.y += (rect.h - ml->h) / 2;
+                        textRect.w = ml->w;
+                        textRect.h = ml->h;
+                        SDL_RenderCopy(renderer, ml->tex, NULL, &textRect);
                     }
                 }
 
-                // --- Logo images, centered with drop shadow and anti-aliased scaling ---
-                int sz = SCALEY(64);
-                int startX = (screen_width - (sz + SCALEX(20) + sz)) / 2;
-                int logoY = SCALEY(140) + 7 * SCALEY(40) + SCALEY(20);
-
-                // Drop shadows for images
-                SDL_Rect r1_shadow = {startX + SCALEX(8), logoY + SCALEY(8), sz, sz};
-                SDL_Rect r2_shadow = {startX + sz + SCALEX(20) + SCALEX(8), logoY + SCALEY(8), sz, sz};
-                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 100);
-                SDL_RenderFillRect(renderer, &r1_shadow);
-                SDL_RenderFillRect(renderer, &r2_shadow);
-
-                // Actual images (now smooth-scaled!)
-                SDL_Rect r1 = {startX, logoY, sz, sz};
-                SDL_Rect r2 = {startX + sz + SCALEX(20), logoY, sz, sz};
-                if (dcT) SDL_RenderCopy(renderer, dcT, NULL, &r1);
-                if (trT) SDL_RenderCopy(renderer, trT, NULL, &r2);
-            }
+                // Draw About overlay if open (drawn below keyboard if both open)
+                if (aboutOpen) {
+                    SDL_Rect ov = {SCALEX(240), SCALEY(140), SCALEX(800), SCALEY(440)};
+                    // Drop shadow for overlay
+                    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+                    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+                    SDL_Rect shadow = {ov.x + SCALEX(14), ov.y + SCALEY(14), ov.w, ov.h};
+                    SDL_RenderFillRect(renderer, &shadow);
+
+                    // About main panel -- SOLID BLACK
+                    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+                    SDL_RenderFillRect(renderer, &ov);
+
+                    // Border
+                    SDL_SetRenderDrawColor(renderer, 80, 255, 100, 255);
+                    SDL_RenderDrawRect(renderer, &ov);
+
+                    // About text content (rendered once, by the loader)
+                    for (int i = 0; i < UI_ABOUT_LINES; i++) {
+                        if (aboutT[i]) SDL_RenderCopy(renderer, aboutT[i], NULL, &aboutR[i]);
+                    }
 
-            // Draw On-Screen Keyboard overlay if open (always drawn on top)
-            if (kybdOpen) {
-                // --- MODAL OVERLAY PANEL WITH DROP SHADOW OUTSIDE ---
-                int panel_w = SCALEX(960);
-                int panel_h = SCALEY(420);
-                int panel_x = (screen_width - panel_w) / 2;
-                int panel_y = (screen_height - panel_h) / 2;
-                SDL_Rect panel = { panel_x, panel_y, panel_w, panel_h };
-
-                // Drop shadow (outside)
-                SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
-                SDL_Rect shadow = { panel.x + SCALEX(14), panel.y + SCALEY(14), panel.w, panel.h };
-                SDL_RenderFillRect(renderer, &shadow);
-
-                // Black modal panel
-                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-                SDL_RenderFillRect(renderer, &panel);
-
-                // Neon green border
-                SDL_SetRenderDrawColor(renderer, 80, 255, 100, 255);
-                SDL_RenderDrawRect(renderer, &panel);
-
-                // Draw the keyboard inside the modal (no extra green backgrounds)
-                kybd_draw(renderer, screen_width, screen_height, kb_text);
+                    // --- Logo images, centered with drop shadow and anti-aliased scaling ---
+                    int sz = SCALEY(64);
+                    int startX = (screen_width - (sz + SCALEX(20) + sz)) / 2;
+                    int logoY = SCALEY(140) + 7 * SCALEY(40) + SCALEY(20);
+
+                    // Drop shadows for images
+                    SDL_Rect r1_shadow = {startX + SCALEX(8), logoY + SCALEY(8), sz, sz};
+                    SDL_Rect r2_shadow = {startX + sz + SCALEX(20) + SCALEX(8), logoY + SCALEY(8), sz, sz};
+                    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 100);
+                    SDL_RenderFillRect(renderer, &r1_shadow);
+                    SDL_RenderFillRect(renderer, &r2_shadow);
+
+                    // Actual images (now smooth-scaled!)
+                    SDL_Rect r1 = {startX, logoY, sz, sz};
+                    SDL_Rect r2 = {startX + sz + SCALEX(20), logoY, sz, sz};
+                    if (dcT) SDL_RenderCopy(renderer, dcT, NULL, &r1);
+                    if (trT) SDL_RenderCopy(renderer, trT, NULL, &r2);
+                }
+
+                // Draw On-Screen Keyboard overlay if open (always drawn on top)
+                if (kybdOpen) {
+                    // --- MODAL OVERLAY PANEL WITH DROP SHADOW OUTSIDE ---
+                    int panel_w = SCALEX(960);
+                    int panel_h = SCALEY(420);
+                    int panel_x = (screen_width - panel_w) / 2;
+                    int panel_y = (screen_height - panel_h) / 2;
+                    SDL_Rect panel = { panel_x, panel_y, panel_w, panel_h };
+
+                    // Drop shadow (outside)
+                    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+                    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+                    SDL_Rect shadow = { panel.x + SCALEX(14), panel.y + SCALEY(14), panel.w, panel.h };
+                    SDL_RenderFillRect(renderer, &shadow);
+
+                    // Black modal panel
+                    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+                    SDL_RenderFillRect(renderer, &panel);
+
+                    // Neon green border
+                    SDL_SetRenderDrawColor(renderer, 80, 255, 100, 255);
+                    SDL_RenderDrawRect(renderer, &panel);
+                }
             }
-        }
+            if (toBase) {
+                SDL_SetRenderTarget(renderer, NULL);
+                baseValid = 1;
+                continue;
+            }
+
+            // Draw the keyboard inside the modal (no extra green backgrounds)
+            if (kybdOpen) kybd_draw(renderer, screen_width, screen_height, kb_text);
 
-        if (ep)  SDL_RenderCopy(renderer, ep,  NULL, &epr);
-        if (eb)  SDL_RenderCopy(renderer, eb,  NULL, &ebr);
-        if (ep2) SDL_RenderCopy(renderer, ep2, NULL, &ep2r);
+            if (ep)  SDL_RenderCopy(renderer, ep,  NULL, &epr);
+            if (eb)  SDL_RenderCopy(renderer, eb,  NULL, &ebr);
+            if (ep2) SDL_RenderCopy(renderer, ep2, NULL, &ep2r);
 
-        if (xiT) SDL_RenderCopy(renderer, xiT, NULL, &xiR);
-        if (stT) SDL_RenderCopy(renderer, stT, NULL, &stR);
-        if (ipT) SDL_RenderCopy(renderer, ipT, NULL, &ipR);
+            if (xiT) SDL_RenderCopy(renderer, xiT, NULL, &xiR);
+            if (stL) SDL_RenderCopy(renderer, stL->tex, NULL, &stR);
+            font_cache_draw(renderer, font24, shownIP, ipR.x, ipR.y, ipCol);
+            font_cache_draw(renderer, font24, cmd_msg, cmdR.x, cmdR.y, cmd_msg_col);
+            if (booting) DrawSplash(renderer);
+            if (stats_open) DrawNetStats(renderer, screen_height);
+        }
+        SDL_RenderSetClipRect(renderer, NULL);
+        damage_clear();
 
         SDL_RenderPresent(renderer);
+        if (!booting && !bootLogged) {
+            uint32_t interactiveMs = SDL_GetTicks() - bootStart;
+            plat_log("Boot: interactive at %u ms (%s)\n", (unsigned)interactiveMs,
+                     BootLoad_UsedPack() ? "asset pack" : "media files");
+            SaveBootTimes(firstFrameMs, interactiveMs);
+            bootLogged = true;
+        }
         SDL_Delay(16);
     }
 
 cleanup:
-    SDL_CloseAudio();
-    if (audio_file) fclose(audio_file);
+    BootLoad_Stop();
+    NetReactor_Stop();
+    AudioStream_Stop();
 
     // --- RESOURCE CLEANUP ---
     if (titleTex) SDL_DestroyTexture(titleTex);
     if (bgTexture) SDL_DestroyTexture(bgTexture);
+    if (modalBase) SDL_DestroyTexture(modalBase);
     if (ep)  SDL_DestroyTexture(ep);
     if (eb)  SDL_DestroyTexture(eb);
     if (ep2) SDL_DestroyTexture(ep2);
     if (xiT) SDL_DestroyTexture(xiT);
-    if (stT) SDL_DestroyTexture(stT);
-    if (ipT) SDL_DestroyTexture(ipT);
+    label_cache_clear();
+    oct_cache_clear();
+    kybd_shutdown();
     if (dcT) SDL_DestroyTexture(dcT);
     if (trT) SDL_DestroyTexture(trT);
+    for (int i = 0; i < UI_ABOUT_LINES; i++) {
+        bool shared = false;   // same text as an earlier line
+        for (int j = 0; j < i; j++) shared |= aboutT[j] == aboutT[i];
+        if (aboutT[i] && !shared) SDL_DestroyTexture(aboutT[i]);
+    }
 
-    if (font48) TTF_CloseFont(font48);
-    if (font24) TTF_CloseFont(font24);
-    if (font28) TTF_CloseFont(font28);
+    font_cache_clear();
 
     if (renderer) SDL_DestroyRenderer(renderer);
     if (window) SDL_DestroyWindow(window);
@@ -0,0 +1,205 @@
+// net_reactor.c - single network thread: select() over every socket plus a timer wheel
+#include "net_reactor.h"
+#include "xifi_detect.h"
+#include "cmd_queue.h"
+#include "platform.h"
+#include <SDL.h>
+#include <string.h>
+
+#define NET_MAX_WATCH   16
+#define WAKE_POLL_MS    20     // select() cap when no loopback wake socket exists
+#define WAKE_TEST_MS    200    // how long the startup test datagram may take
+
+struct net_watch {
+    int fd;
+    int want_read, want_write;
+    net_io_fn fn;
+    void* arg;
+};
+
+static struct net_watch watches[NET_MAX_WATCH];
+static int watch_count = 0;
+static struct timer_wheel wheel;
+
+static SDL_Thread* reactor = NULL;
+static volatile int reactor_running = 0;
+
+// Wake-up datagrams from the UI to a loopback socket in the fd set. If the
+// stack has no loopback, select() just never sleeps longer than WAKE_POLL_MS.
+static int wake_rx = -1, wake_tx = -1;
+static struct sockaddr_in wake_addr;
+static SDL_atomic_t wake_pending;
+
+static void wake_open(void) {
+    wake_rx = socket(AF_INET, SOCK_DGRAM, 0);
+    wake_tx = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&wake_addr, 0, sizeof(wake_addr));
+    wake_addr.sin_family = AF_INET;
+    wake_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    socklen_t len = sizeof(wake_addr);
+    if (wake_rx < 0 || wake_tx < 0 ||
+        bind(wake_rx, (struct sockaddr*)&wake_addr, sizeof(wake_addr)) != 0 ||
+        getsockname(wake_rx, (struct sockaddr*)&wake_addr, &len) != 0) {
+        if (wake_rx >= 0) closesocket(wake_rx);
+        if (wake_tx >= 0) closesocket(wake_tx);
+        wake_rx = wake_tx = -1;
+        return;
+    }
+    int on = 1;
+    ioctlsocket(wake_rx, FIONBIO, &on);
+
+    // A stack can accept the bind and still drop loopback traffic: send one
+    // test datagram and fall back to polling if it never shows up
+    char buf[16];
+    fd_set rs;
+    FD_ZERO(&rs);
+    FD_SET(wake_rx, &rs);
+    struct timeval tv = { 0, WAKE_TEST_MS * 1000 };
+    if (sendto(wake_tx, "t", 1, 0, (struct sockaddr*)&wake_addr, sizeof(wake_addr)) != 1 ||
+        select(wake_rx + 1, &rs, NULL, NULL, &tv) <= 0 ||
+        recv(wake_rx, buf, sizeof(buf), 0) <= 0) {
+        plat_log("Reactor: no loopback wake-ups, polling every %d ms\n", WAKE_POLL_MS);
+        closesocket(wake_rx);
+        closesocket(wake_tx);
+        wake_rx = wake_tx = -1;
+    }
+}
+
+static void wake_close(void) {
+    if (wake_rx >= 0) closesocket(wake_rx);
+    if (wake_tx >= 0) closesocket(wake_tx);
+    wake_rx = wake_tx = -1;
+}
+
+void NetReactor_Wake(void) {
+    // Coalesce: one datagram until the reactor has seen it
+    if (wake_tx < 0 || !SDL_AtomicCAS(&wake_pending, 0, 1)) return;
+    // Nothing went out, so nothing will clear the flag: let the next wake retry
+    if (sendto(wake_tx, "w", 1, 0, (struct sockaddr*)&wake_addr, sizeof(wake_addr)) != 1) {
+        SDL_AtomicSet(&wake_pending, 0);
+    }
+}
+
+bool net_watch(int fd, int want_read, int want_write, net_io_fn fn, void* arg) {
+    struct net_watch* w = NULL;
+    for (int i = 0; i < watch_count; i++) {
+        if (watches[i].fd == fd) w = &watches[i];
+    }
+    if (!w) {
+        if (watch_count == NET_MAX_WATCH) return false;
+        w = &watches[watch_count++];
+    }
+    *w = (struct net_watch){ fd, want_read, want_write, fn, arg };
+    return true;
+}
+
+void net_unwatch(int fd) {
+    for (int i = 0; i < watch_count; i++) {
+        if (watches[i].fd == fd) {
+            watches[i] = watches[--watch_count];
+            return;
+        }
+    }
+}
+
+void net_timer(struct tw_timer* t, uint32_t delay_ms, tw_fn fn, void* arg) {
+    tw_arm(&wheel, t, SDL_GetTicks(), delay_ms, fn, arg);
+}
+
+void net_timer_cancel(struct tw_timer* t) {
+    tw_cancel(&wheel, t);
+}
+
+static int ReactorThread(void* param) {
+    tw_init(&wheel, SDL_GetTicks());
+    XiFi_ReactorBegin();
+    CmdQueue_ReactorBegin();
+
+    while (reactor_running) {
+        XiFi_ReactorPoll();
+        CmdQueue_ReactorPoll();
+
+        fd_set rs, ws;
+        FD_ZERO(&rs);
+        FD_ZERO(&ws);
+        int maxfd = -1;
+        for (int i = 0; i < watch_count; i++) {
+            if (!watches[i].want_read && !watches[i].want_write) continue;
+            if (watches[i].want_read) FD_SET(watches[i].fd, &rs);
+            if (watches[i].want_write) FD_SET(watches[i].fd, &ws);
+            if (watches[i].fd > maxfd) maxfd = watches[i].fd;
+        }
+        if (wake_rx >= 0) {
+            FD_SET(wake_rx, &rs);
+            if (wake_rx > maxfd) maxfd = wake_rx;
+        }
+
+        uint32_t wait = tw_next(&wheel, SDL_GetTicks());
+        if (wake_rx < 0 && wait > WAKE_POLL_MS) wait = WAKE_POLL_MS;
+        if (wait > 1000) wait = 1000;
+        int r = 0;
+        if (maxfd >= 0) {
+            struct timeval tv = { wait / 1000, (wait % 1000) * 1000 };
+            r = select(maxfd + 1, &rs, &ws, NULL, &tv);
+        } else {
+            SDL_Delay(wait);
+        }
+
+        if (r > 0) {
+            if (wake_rx >= 0 && FD_ISSET(wake_rx, &rs)) {
+                char buf[16];
+                SDL_AtomicSet(&wake_pending, 0);
+                while (recv(wake_rx, buf, sizeof(buf), 0) > 0) {}
+            }
+            // Callbacks may add or drop watches: snapshot the ready ones first
+            struct net_watch ready[NET_MAX_WATCH];
+            int rd[NET_MAX_WATCH], wr[NET_MAX_WATCH], n = 0;
+            for (int i = 0; i < watch_count; i++) {
+                int fr = watches[i].want_read && FD_ISSET(watches[i].fd, &rs);
+                int fw = watches[i].want_write && FD_ISSET(watches[i].fd, &ws);
+                if (!fr && !fw) continue;
+                ready[n] = watches[i];
+                rd[n] = fr;
+                wr[n++] = fw;
+            }
+            for (int i = 0; i < n; i++) {
+                // Skip a watch that an earlier callback removed or replaced
+                int live = 0;
+                for (int j = 0; j < watch_count; j++) {
+                    live |= watches[j].fd == ready[i].fd && watches[j].fn == ready[i].fn &&
+                            watches[j].arg == ready[i].arg;
+                }
+                if (live) ready[i].fn(ready[i].arg, rd[i], wr[i]);
+            }
+        }
+        tw_run(&wheel, SDL_GetTicks());
+    }
+
+    CmdQueue_ReactorEnd();
+    XiFi_ReactorEnd();
+    return 0;
+}
+
+bool NetReactor_Start(void) {
+    if (reactor_running) return true;
+    wake_open();
+    SDL_AtomicSet(&wake_pending, 0);
+    reactor_running = 1;
+    reactor = SDL_CreateThread(ReactorThread, "XiFiNet", NULL);
+    if (!reactor) {
+        reactor_running = 0;
+        wake_close();
+        return false;
+    }
+    return true;
+}
+
+void NetReactor_Stop(void) {
+    if (!reactor) return;
+    reactor_running = 0;
+    SDL_AtomicSet(&wake_pending, 0);
+    NetReactor_Wake();
+    SDL_WaitThread(reactor, NULL);
+    reactor = NULL;
+    wake_close();
+}
@@ -0,0 +1,41 @@
+#ifndef NET_REACTOR_H
+#define NET_REACTOR_H
+
+#include <stdbool.h>
+#include "timer_wheel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One network thread owns every socket: the UDP discovery socket, the TCP
+// command connections and the timers behind heartbeats, timeouts and idle
+// closes. It sleeps in select() until a socket is ready, a timer is due or
+// the UI wakes it, and talks to the UI only through lock-free SPSC rings
+// (cmd_queue) and the detection seqlock (xifi_detect).
+
+// Start/stop the reactor thread (Start is safe to call more than once)
+bool NetReactor_Start(void);
+void NetReactor_Stop(void);
+
+// Any thread but lwIP's own: new work is waiting, leave select() now
+void NetReactor_Wake(void);
+
+// --- Reactor thread only ---
+
+typedef void (*net_io_fn)(void* arg, int readable, int writable);
+
+// Watch fd (replacing any earlier watch on it). Both wants may be 0 to park
+// it. Returns false if the watch table is full.
+bool net_watch(int fd, int want_read, int want_write, net_io_fn fn, void* arg);
+void net_unwatch(int fd);
+
+// One-shot timers on the reactor's wheel
+void net_timer(struct tw_timer* t, uint32_t delay_ms, tw_fn fn, void* arg);
+void net_timer_cancel(struct tw_timer* t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_REACTOR_H
@@ -0,0 +1,173 @@
+// net_stats.c - network counters and HDR-style latency histograms
+#include "net_stats.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+#define HIST_SUB     16                       // linear sub-buckets per power of two
+#define HIST_BUCKETS (HIST_SUB + 28 * HIST_SUB)   // values 0..15, then 2^4 .. 2^32
+
+struct hist {
+    uint32_t counts[HIST_BUCKETS];
+    uint32_t n;
+    uint32_t max;
+};
+
+static struct hist hists[NS_HIST_COUNT];
+static uint32_t counters[NS_COUNTER_COUNT];
+static uint32_t failures[SEND_ERR_OFFLINE + 1];   // by send_status
+static SDL_SpinLock lock = 0;
+
+static const char* hist_names[NS_HIST_COUNT] = {
+    "probe rtt", "detect", "connect", "send", "response", "total"
+};
+
+static int bucket_of(uint32_t v) {
+    if (v < HIST_SUB) return (int)v;
+    int msb = 31;
+    while (!(v >> msb)) msb--;
+    int shift = msb - 4;
+    return HIST_SUB + shift * HIST_SUB + (int)((v >> shift) & (HIST_SUB - 1));
+}
+
+// Largest value that lands in bucket i
+static uint32_t bucket_high(int i) {
+    if (i < HIST_SUB) return (uint32_t)i;
+    int shift = (i - HIST_SUB) / HIST_SUB;
+    uint64_t low = (uint64_t)(HIST_SUB + (i - HIST_SUB) % HIST_SUB) << shift;
+    uint64_t high = low + ((uint64_t)1 << shift) - 1;
+    return high > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)high;
+}
+
+static uint32_t percentile(const struct hist* h, int pct) {
+    if (!h->n) return 0;
+    uint64_t want = ((uint64_t)h->n * pct + 99) / 100, seen = 0;
+    if (want == 0) want = 1;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= want) {
+            uint32_t v = bucket_high(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+void net_stats_count(enum net_counter c) {
+    SDL_AtomicLock(&lock);
+    counters[c]++;
+    SDL_AtomicUnlock(&lock);
+}
+
+void net_stats_record(enum net_hist h, uint32_t us) {
+    SDL_AtomicLock(&lock);
+    struct hist* hs = &hists[h];
+    hs->counts[bucket_of(us)]++;
+    hs->n++;
+    if (us > hs->max) hs->max = us;
+    SDL_AtomicUnlock(&lock);
+}
+
+void net_stats_result(const struct send_result* res, uint32_t total_us) {
+    SDL_AtomicLock(&lock);
+    counters[NS_CMDS]++;
+    if (res->status != SEND_OK) {
+        if ((unsigned)res->status <= SEND_ERR_OFFLINE) failures[res->status]++;
+    } else if (send_result_ok(res)) {
+        counters[NS_CMDS_OK]++;
+    } else {
+        counters[NS_CMDS_REJECTED]++;
+    }
+    SDL_AtomicUnlock(&lock);
+    if (res->status == SEND_OK) net_stats_record(NS_RESPONSE, res->latency_us);
+    net_stats_record(NS_TOTAL, total_us);
+}
+
+void net_stats_hist(enum net_hist h, struct net_hist_summary* out) {
+    SDL_AtomicLock(&lock);
+    const struct hist* hs = &hists[h];
+    out->n = hs->n;
+    out->p50 = percentile(hs, 50);
+    out->p95 = percentile(hs, 95);
+    out->p99 = percentile(hs, 99);
+    out->max = hs->max;
+    SDL_AtomicUnlock(&lock);
+}
+
+// Microseconds as milliseconds with two decimals (no float printf needed)
+static const char* ms_text(uint32_t us, char* buf, int len) {
+    snprintf(buf, len, "%u.%02u", (unsigned)(us / 1000), (unsigned)(us % 1000 / 10));
+    return buf;
+}
+
+int net_stats_format(char lines[][NET_STATS_LINE], int max) {
+    uint32_t c[NS_COUNTER_COUNT], f[SEND_ERR_OFFLINE + 1];
+    SDL_AtomicLock(&lock);
+    memcpy(c, counters, sizeof(c));
+    memcpy(f, failures, sizeof(f));
+    SDL_AtomicUnlock(&lock);
+
+    int n = 0;
+    if (n < max) snprintf(lines[n++], NET_STATS_LINE,
+                          "Probes %u sent, %u answered  detected %u  lost %u  sweeps %u",
+                          c[NS_PROBES_SENT], c[NS_PROBE_REPLIES], c[NS_DETECTIONS],
+                          c[NS_LOSSES], c[NS_SWEEPS]);
+    uint32_t failed = c[NS_CMDS] - c[NS_CMDS_OK] - c[NS_CMDS_REJECTED];
+    if (n < max) snprintf(lines[n++], NET_STATS_LINE,
+                          "Commands %u: %u ok, %u rejected, %u failed",
+                          c[NS_CMDS], c[NS_CMDS_OK], c[NS_CMDS_REJECTED], failed);
+    if (n < max) {
+        char* l = lines[n++];
+        int len = snprintf(l, NET_STATS_LINE, "Failures:");
+        for (int s = 1; s <= SEND_ERR_OFFLINE && len < NET_STATS_LINE; s++) {
+            if (f[s]) len += snprintf(l + len, NET_STATS_LINE - len, " %s %u",
+                                      send_status_str((enum send_status)s), f[s]);
+        }
+        if (!failed && len < NET_STATS_LINE) snprintf(l + len, NET_STATS_LINE - len, " none");
+    }
+    if (n < max) snprintf(lines[n++], NET_STATS_LINE, "%-9s %6s %8s %8s %8s %8s",
+                          "ms", "n", "p50", "p95", "p99", "max");
+    for (int h = 0; h < NS_HIST_COUNT && n < max; h++) {
+        struct net_hist_summary s;
+        char a[16], b[16], d[16], e[16];
+        net_stats_hist((enum net_hist)h, &s);
+        snprintf(lines[n++], NET_STATS_LINE, "%-9s %6u %8s %8s %8s %8s", hist_names[h], s.n,
+                 ms_text(s.p50, a, sizeof(a)), ms_text(s.p95, b, sizeof(b)),
+                 ms_text(s.p99, d, sizeof(d)), ms_text(s.max, e, sizeof(e)));
+    }
+    return n;
+}
+
+bool net_stats_dump(const char* path) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    char lines[16][NET_STATS_LINE];
+    int n = net_stats_format(lines, 16);
+    fprintf(f, "# XiFi network stats, %u ms after start\n", (unsigned)SDL_GetTicks());
+    for (int i = 0; i < n; i++) fprintf(f, "%s\n", lines[i]);
+
+    // Full distributions: bucket upper bound, count, cumulative share
+    static struct hist copy;
+    for (int h = 0; h < NS_HIST_COUNT; h++) {
+        SDL_AtomicLock(&lock);
+        copy = hists[h];
+        SDL_AtomicUnlock(&lock);
+        fprintf(f, "\n# %s: value_us count cumulative\n", hist_names[h]);
+        uint32_t seen = 0;
+        for (int i = 0; i < HIST_BUCKETS; i++) {
+            if (!copy.counts[i]) continue;
+            seen += copy.counts[i];
+            fprintf(f, "%u %u %u.%03u\n", bucket_high(i), copy.counts[i],
+                    (unsigned)(seen / copy.n), (unsigned)((uint64_t)(seen % copy.n) * 1000 / copy.n));
+        }
+    }
+    return fclose(f) == 0;
+}
+
+void net_stats_reset(void) {
+    SDL_AtomicLock(&lock);
+    memset(hists, 0, sizeof(hists));
+    memset(counters, 0, sizeof(counters));
+    memset(failures, 0, sizeof(failures));
+    SDL_AtomicUnlock(&lock);
+}
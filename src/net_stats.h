@@ -0,0 +1,67 @@
+#ifndef NET_STATS_H
+#define NET_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "send_cmd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Network counters and latency histograms. The network reactor records,
+// any thread may read. Histograms are HDR-style log-linear: 16 linear
+// sub-buckets per power of two, so every recorded value keeps about 6%
+// precision from 1 us up to the full uint32_t range in fixed memory.
+
+enum net_hist {
+    NS_PROBE_RTT,     // discovery/heartbeat probe to "XiFi: PRESENT"
+    NS_DETECT,        // first discovery probe to detection
+    NS_CONNECT,       // TCP connect started -> established
+    NS_SEND,          // request write started -> fully written
+    NS_RESPONSE,      // request written -> response complete
+    NS_TOTAL,         // command queued by the UI -> result back
+    NS_HIST_COUNT
+};
+
+enum net_counter {
+    NS_PROBES_SENT,
+    NS_PROBE_REPLIES,
+    NS_DETECTIONS,
+    NS_LOSSES,        // heartbeat gave up on every device
+    NS_SWEEPS,
+    NS_CMDS,          // commands finished, any outcome
+    NS_CMDS_OK,       // delivered and accepted (2xx)
+    NS_CMDS_REJECTED, // delivered, non-2xx answer
+    NS_COUNTER_COUNT
+};
+
+#define NET_STATS_LINE 72
+
+void net_stats_count(enum net_counter c);
+void net_stats_record(enum net_hist h, uint32_t us);
+
+// Account one finished command: its outcome, failure cause and latencies
+void net_stats_result(const struct send_result* res, uint32_t total_us);
+
+// Summary of one histogram, in microseconds
+struct net_hist_summary {
+    uint32_t n;
+    uint32_t p50, p95, p99, max;
+};
+void net_stats_hist(enum net_hist h, struct net_hist_summary* out);
+
+// Human readable summary (counters, p50/p95/p99/max per histogram, failures
+// by cause) as up to max lines; returns the number written
+int net_stats_format(char lines[][NET_STATS_LINE], int max);
+
+// Write the summary plus every histogram's full distribution to path
+bool net_stats_dump(const char* path);
+
+void net_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_STATS_H
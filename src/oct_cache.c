@@ -0,0 +1,129 @@
+// oct_cache.c - pre-rasterized, anti-aliased octagon button sprites
+#include "oct_cache.h"
+#include <string.h>
+#include <stdint.h>
+
+#define OCT_CACHE_SIZE   32
+#define OCT_SUBSAMPLES   4      // 4x4 coverage samples per pixel
+#define OCT_SHADOW_ALPHA 80
+#define SQRT2            1.41421356f
+
+struct oct_entry {
+    SDL_Texture* tex;
+    int w, h, m, sdx, sdy;
+    SDL_Color fill, border;
+    uint32_t last_use;
+};
+
+static struct oct_entry cache[OCT_CACHE_SIZE];
+static uint32_t use_clock = 0;
+
+static int same_color(SDL_Color a, SDL_Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+// Is (x,y) inside the octagon of outer size W x H and corner cut m, shrunk by inset?
+static int oct_inside(float x, float y, float W, float H, float m, float inset) {
+    if (x < inset || y < inset || x > W - inset || y > H - inset) return 0;
+    float d = m + inset * SQRT2;
+    return (x + y >= d) && ((W - x) + y >= d) &&
+           (x + (H - y) >= d) && ((W - x) + (H - y) >= d);
+}
+
+// Fraction of pixel (px,py) covered by the octagon, 0..1
+static float oct_coverage(int px, int py, float W, float H, float m, float inset) {
+    int hits = 0;
+    for (int sy = 0; sy < OCT_SUBSAMPLES; sy++) {
+        float y = py + (sy + 0.5f) / OCT_SUBSAMPLES;
+        for (int sx = 0; sx < OCT_SUBSAMPLES; sx++) {
+            float x = px + (sx + 0.5f) / OCT_SUBSAMPLES;
+            hits += oct_inside(x, y, W, H, m, inset);
+        }
+    }
+    return hits / (float)(OCT_SUBSAMPLES * OCT_SUBSAMPLES);
+}
+
+// Straight-alpha "over" of (c, a) onto dst[0..3] = r,g,b,a (all 0..1)
+static void blend_over(float* dst, SDL_Color c, float a) {
+    if (a <= 0.f) return;
+    float da = dst[3] * (1.f - a);
+    float oa = a + da;
+    dst[0] = (c.r / 255.f * a + dst[0] * da) / oa;
+    dst[1] = (c.g / 255.f * a + dst[1] * da) / oa;
+    dst[2] = (c.b / 255.f * a + dst[2] * da) / oa;
+    dst[3] = oa;
+}
+
+static SDL_Texture* oct_build(SDL_Renderer* r, int w, int h, int m, SDL_Color fill,
+                              SDL_Color border, int sdx, int sdy) {
+    // Outer octagon spans the rect plus margin, inclusive of its last row/column
+    float W = (float)(w + 2*m + 1), H = (float)(h + 2*m + 1);
+    int sw = w + 2*m + 1 + sdx, sh = h + 2*m + 1 + sdy;
+    SDL_Surface* s = SDL_CreateRGBSurfaceWithFormat(0, sw, sh, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (!s) return NULL;
+
+    SDL_Color black = {0, 0, 0, 255};
+    SDL_LockSurface(s);
+    for (int y = 0; y < sh; y++) {
+        uint32_t* row = (uint32_t*)((uint8_t*)s->pixels + y * s->pitch);
+        for (int x = 0; x < sw; x++) {
+            float px[4] = {0, 0, 0, 0};
+            if (sdx || sdy) {
+                float cs = oct_coverage(x - sdx, y - sdy, W, H, (float)m, 0.f);
+                blend_over(px, black, cs * OCT_SHADOW_ALPHA / 255.f);
+            }
+            float outer = oct_coverage(x, y, W, H, (float)m, 0.f);
+            float inner = oct_coverage(x, y, W, H, (float)m, 1.f);
+            blend_over(px, fill, inner * fill.a / 255.f);
+            blend_over(px, border, (outer - inner) * border.a / 255.f);
+            row[x] = ((uint32_t)(px[3] * 255.f + 0.5f) << 24) |
+                     ((uint32_t)(px[0] * 255.f + 0.5f) << 16) |
+                     ((uint32_t)(px[1] * 255.f + 0.5f) << 8) |
+                      (uint32_t)(px[2] * 255.f + 0.5f);
+        }
+    }
+    SDL_UnlockSurface(s);
+
+    SDL_Texture* tex = SDL_CreateTextureFromSurface(r, s);
+    SDL_FreeSurface(s);
+    if (tex) SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+    return tex;
+}
+
+void oct_draw(SDL_Renderer* r, SDL_Rect rc, int m, SDL_Color fill, SDL_Color border,
+              int shadow_dx, int shadow_dy) {
+    struct oct_entry* hit = NULL;
+    struct oct_entry* victim = &cache[0];
+    for (int i = 0; i < OCT_CACHE_SIZE; i++) {
+        struct oct_entry* e = &cache[i];
+        if (e->tex && e->w == rc.w && e->h == rc.h && e->m == m &&
+            e->sdx == shadow_dx && e->sdy == shadow_dy &&
+            same_color(e->fill, fill) && same_color(e->border, border)) {
+            hit = e;
+            break;
+        }
+        if (!victim->tex) continue;
+        if (!e->tex || e->last_use < victim->last_use) victim = e;
+    }
+
+    if (!hit) {
+        SDL_Texture* tex = oct_build(r, rc.w, rc.h, m, fill, border, shadow_dx, shadow_dy);
+        if (!tex) return;
+        if (victim->tex) SDL_DestroyTexture(victim->tex);
+        *victim = (struct oct_entry){ tex, rc.w, rc.h, m, shadow_dx, shadow_dy, fill, border, 0 };
+        hit = victim;
+    }
+    hit->last_use = ++use_clock;
+
+    SDL_Rect dst = { rc.x - m, rc.y - m,
+                     rc.w + 2*m + 1 + shadow_dx, rc.h + 2*m + 1 + shadow_dy };
+    SDL_RenderCopy(r, hit->tex, NULL, &dst);
+}
+
+void oct_cache_clear(void) {
+    for (int i = 0; i < OCT_CACHE_SIZE; i++) {
+        if (cache[i].tex) SDL_DestroyTexture(cache[i].tex);
+    }
+    memset(cache, 0, sizeof(cache));
+    use_clock = 0;
+}
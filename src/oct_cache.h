@@ -0,0 +1,24 @@
+#ifndef OCT_CACHE_H
+#define OCT_CACHE_H
+
+#include <SDL.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Draws an octagonal button around rc (corners cut by margin m) with a 1px
+// border and an optional drop shadow offset by (shadow_dx, shadow_dy).
+// The sprite is rasterized once per (size, margin, colors, shadow) and
+// then drawn as a single SDL_RenderCopy.
+void oct_draw(SDL_Renderer* r, SDL_Rect rc, int m, SDL_Color fill, SDL_Color border,
+              int shadow_dx, int shadow_dy);
+
+// Destroys every cached sprite (call on video mode change or shutdown).
+void oct_cache_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OCT_CACHE_H
@@ -0,0 +1,78 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Socket API: lwIP on the Xbox, BSD sockets on the host build
+#ifdef XIFI_HOST
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#define closesocket(s) close(s)
+#define ioctlsocket(s, cmd, argp) ioctl(s, cmd, argp)
+#else
+#include <lwip/sockets.h>
+#include <lwip/inet.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pick the best supported video mode and report its size. Returns false if
+// no mode could be set.
+bool plat_video_init(int* width, int* height);
+
+// Local interface state. seq moves on every link or address change.
+struct plat_net_state {
+    bool link_up;
+    uint32_t ipv4;        // network byte order, 0 = no address yet
+    uint32_t netmask;     // network byte order
+    uint32_t seq;
+    char source[16];      // "DHCP", "static", "link-local", "No NIC", ...
+};
+
+// Bring up the network stack and start address configuration without
+// waiting for it. Returns false on failure.
+bool plat_net_init(void);
+
+// Wait up to timeout_ms for the interface state to move past seq, then fill
+// *out with the current state. Returns true if it changed. Address
+// fallback (static config, link-local) is driven from here as well.
+bool plat_net_wait(uint32_t seq, uint32_t timeout_ms, struct plat_net_state* out);
+
+// Have fn called, from a platform thread (never the stack's own), whenever
+// the interface state moves, so the caller can sleep instead of polling
+// plat_net_wait. NULL stops the calls. Returns false if the platform can't
+// notify; the caller then has to poll.
+bool plat_net_notify(void (*fn)(void));
+
+// printf-style diagnostics, from any thread (xifi.log next to the XBE on
+// the Xbox, stderr on the host)
+void plat_log(const char* fmt, ...);
+
+// An error the app is about to quit on: logged, and on the Xbox also shown
+// on the debug screen, as nothing else will be drawn after it
+void plat_fatal(const char* fmt, ...);
+
+// Resolve an asset path relative to the media root, written with '/'
+// separators (e.g. "img/background.jpg"). Returns buf.
+const char* plat_asset_path(const char* rel, char* buf, size_t len);
+
+// Resolve a path for small writable state (caches, settings). Same rules as
+// plat_asset_path. Writes may fail (e.g. read-only media); callers must cope.
+const char* plat_data_path(const char* rel, char* buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PLATFORM_H
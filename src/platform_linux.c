@@ -0,0 +1,106 @@
+// platform_linux.c - native Linux backend for profiling and regression runs
+//
+// Environment:
+//   XIFI_MEDIA  asset root (default "media", i.e. run from the repo root)
+//   XIFI_MODE   window size as WxH (default 1280x720)
+//   XIFI_DATA   writable state directory (default ".")
+#include "platform.h"
+#include <SDL.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+#define DEFAULT_MEDIA_ROOT "media"
+#define DEFAULT_DATA_ROOT  "."
+#define NET_POLL_MS        250
+
+bool plat_video_init(int* width, int* height) {
+    int w = 1280, h = 720;
+    const char* mode = getenv("XIFI_MODE");
+    if (mode && sscanf(mode, "%dx%d", &w, &h) != 2) {
+        w = 1280;
+        h = 720;
+    }
+    if (w <= 0 || h <= 0) return false;
+    *width = w;
+    *height = h;
+    return true;
+}
+
+bool plat_net_init(void) {
+    return true;
+}
+
+// The host has no stack callbacks to hook, so the interface list is sampled.
+// Only the network reactor calls this; no locking needed.
+static struct plat_net_state net_state = { false, 0, 0, 0, "host" };
+
+static void net_sample(void) {
+    struct ifaddrs* ifs = NULL;
+    bool link = false;
+    uint32_t ip = 0, mask = 0;
+    if (getifaddrs(&ifs) == 0) {
+        for (struct ifaddrs* i = ifs; i; i = i->ifa_next) {
+            if (!i->ifa_addr || i->ifa_addr->sa_family != AF_INET) continue;
+            if ((i->ifa_flags & IFF_LOOPBACK) || !(i->ifa_flags & IFF_UP)) continue;
+            link = (i->ifa_flags & IFF_RUNNING) != 0;
+            ip = ((struct sockaddr_in*)i->ifa_addr)->sin_addr.s_addr;
+            if (i->ifa_netmask) mask = ((struct sockaddr_in*)i->ifa_netmask)->sin_addr.s_addr;
+            break;
+        }
+        freeifaddrs(ifs);
+    }
+    snprintf(net_state.source, sizeof(net_state.source), "%s", ip ? "host" : "No NIC");
+    if (link != net_state.link_up || ip != net_state.ipv4 || mask != net_state.netmask) {
+        net_state.link_up = link;
+        net_state.ipv4 = ip;
+        net_state.netmask = mask;
+        net_state.seq++;
+    }
+}
+
+bool plat_net_wait(uint32_t seq, uint32_t timeout_ms, struct plat_net_state* out) {
+    uint32_t start = SDL_GetTicks();
+    for (;;) {
+        net_sample();
+        uint32_t waited = SDL_GetTicks() - start;
+        if (net_state.seq != seq || waited >= timeout_ms) break;
+        uint32_t slice = timeout_ms - waited;
+        SDL_Delay(slice < NET_POLL_MS ? slice : NET_POLL_MS);
+    }
+    *out = net_state;
+    return out->seq != seq;
+}
+
+// Nothing on the host tells us about interface changes
+bool plat_net_notify(void (*fn)(void)) {
+    return false;
+}
+
+void plat_log(const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
+
+void plat_fatal(const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
+
+const char* plat_asset_path(const char* rel, char* buf, size_t len) {
+    const char* root = getenv("XIFI_MEDIA");
+    snprintf(buf, len, "%s/%s", root && root[0] ? root : DEFAULT_MEDIA_ROOT, rel);
+    return buf;
+}
+
+const char* plat_data_path(const char* rel, char* buf, size_t len) {
+    const char* root = getenv("XIFI_DATA");
+    snprintf(buf, len, "%s/%s", root && root[0] ? root : DEFAULT_DATA_ROOT, rel);
+    return buf;
+}
@@ -0,0 +1,265 @@
+// platform_nxdk.c - original Xbox backend (nxdk + lwIP)
+#include "platform.h"
+#include <hal/video.h>
+#include <hal/debug.h>
+#include <windows.h>
+#include <nxdk/net.h>
+#include <lwip/netif.h>
+#include <lwip/dhcp.h>
+#include <lwip/tcpip.h>
+#if LWIP_AUTOIP
+#include <lwip/autoip.h>
+#endif
+#include <SDL.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#define MEDIA_ROOT      "D:\\media\\"
+#define DATA_ROOT       "D:\\"          // next to default.xbe
+#define DHCP_FALLBACK_MS 8000        // then static config or link-local
+#define NET_POLL_MS     100
+#define STATIC_NET_FILE "net_static.txt"
+#define LOG_FILE        "xifi.log"      // rewritten every boot
+
+bool plat_video_init(int* width, int* height) {
+    struct { int w, h, mode; } modes[] = {
+        {1280, 720, REFRESH_DEFAULT},
+        {720, 480, REFRESH_DEFAULT},
+        {640, 480, REFRESH_DEFAULT},
+    };
+    for (size_t i = 0; i < sizeof(modes)/sizeof(modes[0]); ++i) {
+        if (XVideoSetMode(modes[i].w, modes[i].h, 32, modes[i].mode) == TRUE) {
+            *width = modes[i].w;
+            *height = modes[i].h;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Interface state is pushed by lwIP's netif callbacks (tcpip thread) and
+// read by the detection thread; net_lock/net_cond hand it across.
+static SDL_mutex* net_lock;
+static SDL_cond* net_cond;
+static struct plat_net_state net_state;
+static uint32_t dhcp_started_at;
+static int fallback_done;
+
+static void net_refresh(struct netif* nif) {
+    SDL_LockMutex(net_lock);
+    bool link = netif_is_up(nif) && netif_is_link_up(nif);
+    uint32_t ip = ip4_addr_get_u32(netif_ip4_addr(nif));
+    uint32_t mask = ip4_addr_get_u32(netif_ip4_netmask(nif));
+    if (link != net_state.link_up || ip != net_state.ipv4 || mask != net_state.netmask) {
+        net_state.link_up = link;
+        net_state.ipv4 = ip;
+        net_state.netmask = mask;
+        net_state.seq++;
+        SDL_CondBroadcast(net_cond);
+    }
+    SDL_UnlockMutex(net_lock);
+}
+
+static void net_set_source(const char* source) {
+    SDL_LockMutex(net_lock);
+    snprintf(net_state.source, sizeof(net_state.source), "%s", source);
+    SDL_UnlockMutex(net_lock);
+}
+
+static void net_register_cb(void* arg) {
+    struct netif* nif = arg;
+#if LWIP_NETIF_STATUS_CALLBACK
+    netif_set_status_callback(nif, net_refresh);
+#endif
+#if LWIP_NETIF_LINK_CALLBACK
+    netif_set_link_callback(nif, net_refresh);
+#endif
+    if (ip_addr_isany_val(nif->ip_addr)) dhcp_start(nif);
+    net_refresh(nif);
+}
+
+static void net_refresh_cb(void* arg) {
+    net_refresh(arg);
+}
+
+// Static config from STATIC_NET_FILE ("ip netmask gateway"), read on the
+// thread running plat_net_wait: the tcpip thread must never wait on the disk
+static struct { int have; ip4_addr_t ip, mask, gw; } static_cfg;
+
+static void load_static_cfg(void) {
+    char path[256], a[16], m[16], g[16];
+    FILE* f = fopen(plat_data_path(STATIC_NET_FILE, path, sizeof(path)), "r");
+    int n = f ? fscanf(f, "%15s %15s %15s", a, m, g) : 0;
+    if (f) fclose(f);
+    static_cfg.have = n == 3;
+    if (static_cfg.have) {
+        static_cfg.ip.addr = inet_addr(a);
+        static_cfg.mask.addr = inet_addr(m);
+        static_cfg.gw.addr = inet_addr(g);
+    }
+}
+
+// No DHCP lease in time: use the static config if there is one (DHCP is
+// stopped so it can't replace it), otherwise a link-local address.
+static void net_fallback_cb(void* arg) {
+    struct netif* nif = arg;
+    if (static_cfg.have) {
+        dhcp_stop(nif);
+        netif_set_addr(nif, &static_cfg.ip, &static_cfg.mask, &static_cfg.gw);
+        net_set_source("static");
+    } else {
+#if LWIP_AUTOIP
+        autoip_start(nif);   // DHCP keeps retrying; a lease replaces this
+        net_set_source("link-local");
+#else
+        net_set_source("No DHCP");
+#endif
+    }
+    net_refresh(nif);
+}
+
+bool plat_net_init(void) {
+    if (nxNetInit(NULL) != 0) return false;
+    net_lock = SDL_CreateMutex();
+    net_cond = SDL_CreateCond();
+    struct netif* nif = netif_default;
+    if (!nif) {
+        snprintf(net_state.source, sizeof(net_state.source), "No NIC");
+        return true;
+    }
+    snprintf(net_state.source, sizeof(net_state.source), "DHCP");
+    dhcp_started_at = SDL_GetTicks();
+    tcpip_callback(net_register_cb, nif);
+    return true;
+}
+
+bool plat_net_wait(uint32_t seq, uint32_t timeout_ms, struct plat_net_state* out) {
+    struct netif* nif = netif_default;
+    uint32_t start = SDL_GetTicks();
+    SDL_LockMutex(net_lock);
+    for (;;) {
+        if (net_state.seq != seq) break;
+        // Fallback and sampling run before the timeout check so a zero
+        // timeout (the network reactor's poll) still drives them
+        uint32_t since = SDL_GetTicks() - dhcp_started_at;
+        int pending = nif && !fallback_done && !net_state.ipv4;
+        if (pending && since >= DHCP_FALLBACK_MS) {
+            fallback_done = 1;
+            pending = 0;
+            SDL_UnlockMutex(net_lock);
+            load_static_cfg();
+            tcpip_callback(net_fallback_cb, nif);
+            SDL_LockMutex(net_lock);
+            if (net_state.seq != seq) break;
+        }
+#if !LWIP_NETIF_STATUS_CALLBACK || !LWIP_NETIF_LINK_CALLBACK
+        // Stack built without netif callbacks: sample the interface on the
+        // tcpip thread; a change wakes the wait below. Posted unlocked, as
+        // net_refresh takes net_lock and the post can block on a full mbox.
+        if (nif) {
+            SDL_UnlockMutex(net_lock);
+            tcpip_callback(net_refresh_cb, nif);
+            SDL_LockMutex(net_lock);
+            if (net_state.seq != seq) break;
+        }
+#endif
+        uint32_t waited = SDL_GetTicks() - start;
+        if (waited >= timeout_ms) break;
+        uint32_t slice = timeout_ms - waited;
+        if (pending && slice > DHCP_FALLBACK_MS - since) slice = DHCP_FALLBACK_MS - since;
+#if !LWIP_NETIF_STATUS_CALLBACK || !LWIP_NETIF_LINK_CALLBACK
+        if (slice > NET_POLL_MS) slice = NET_POLL_MS;
+#endif
+        SDL_CondWaitTimeout(net_cond, net_lock, slice);
+    }
+    *out = net_state;
+    SDL_UnlockMutex(net_lock);
+    return out->seq != seq;
+}
+
+// lwIP's netif callbacks run on the tcpip thread, where the socket API
+// can't be used, so a thread of our own waits for the change and calls out
+static SDL_atomic_t notify_fn;    // void (*)(void), NULL when nobody listens
+static SDL_Thread* notifier;
+
+static int NotifyThread(void* arg) {
+    struct plat_net_state st;
+    uint32_t seq = 0;
+    for (;;) {
+        // Sleeps until a change or the DHCP fallback deadline
+        if (!plat_net_wait(seq, 60000, &st)) continue;
+        seq = st.seq;
+        void (*fn)(void) = (void (*)(void))SDL_AtomicGetPtr((void**)&notify_fn);
+        if (fn) fn();
+    }
+    return 0;
+}
+
+bool plat_net_notify(void (*fn)(void)) {
+    SDL_AtomicSetPtr((void**)&notify_fn, (void*)fn);
+    if (!fn || notifier) return true;
+    notifier = SDL_CreateThread(NotifyThread, "XiFiNetif", NULL);
+    if (!notifier) {
+        SDL_AtomicSetPtr((void**)&notify_fn, NULL);
+        return false;
+    }
+    SDL_DetachThread(notifier);   // runs for the life of the app
+    return true;
+}
+
+// Diagnostics go to LOG_FILE: debugPrint draws straight onto the SDL
+// framebuffer, where nothing repaints over it, and isn't thread safe.
+// log_lock keeps lines from different threads whole.
+static SDL_SpinLock log_lock;
+static FILE* log_file;
+static int log_opened;
+
+static void log_line(const char* line) {
+    SDL_AtomicLock(&log_lock);
+    if (!log_opened) {
+        char path[256];
+        log_opened = 1;
+        log_file = fopen(plat_data_path(LOG_FILE, path, sizeof(path)), "w");
+    }
+    if (log_file) {
+        fputs(line, log_file);
+        fflush(log_file);   // keep what was logged if the app dies
+    }
+    SDL_AtomicUnlock(&log_lock);
+}
+
+void plat_log(const char* fmt, ...) {
+    char line[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    log_line(line);
+}
+
+void plat_fatal(const char* fmt, ...) {
+    char line[256];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    log_line(line);
+    debugPrint("%s", line);
+}
+
+static const char* xbox_path(const char* root, const char* rel, char* buf, size_t len) {
+    size_t n = snprintf(buf, len, "%s%s", root, rel);
+    if (n >= len) n = len - 1;
+    for (size_t i = 0; i < n; i++) {
+        if (buf[i] == '/') buf[i] = '\\';
+    }
+    return buf;
+}
+
+const char* plat_asset_path(const char* rel, char* buf, size_t len) {
+    return xbox_path(MEDIA_ROOT, rel, buf, len);
+}
+
+const char* plat_data_path(const char* rel, char* buf, size_t len) {
+    return xbox_path(DATA_ROOT, rel, buf, len);
+}
@@ -2,8 +2,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <lwip/sockets.h>
-#include <hal/debug.h>  // For debugPrint()
+#include <SDL.h>
+#include "platform.h"
+#include "http_resp.h"
+#include "net_stats.h"
 
 #define XIFI_CMD_PORT 1337   // Set your XiFi HTTP port here
 
@@ -15,32 +17,262 @@ void ascii_to_hex(const char* ascii, char* hexbuf, int hexbufsize) {
     hexbuf[len] = 0;
 }
 
-bool send_cmd(const char* ip, const char* cmd_hex, const char* hex_arg) {
-    if (!ip || !cmd_hex) {
-        return false;
+const char* send_status_str(enum send_status st) {
+    switch (st) {
+        case SEND_OK:          return "OK";
+        case SEND_ERR_ARGS:    return "Bad request";
+        case SEND_ERR_SOCKET:  return "No socket";
+        case SEND_ERR_CONNECT: return "Connect failed";
+        case SEND_ERR_TIMEOUT: return "Timed out";
+        case SEND_ERR_SEND:    return "Send failed";
+        case SEND_ERR_RECV:    return "No response";
+        case SEND_ERR_OFFLINE: return "XiFi offline";
     }
-    char url[256];
-    if (hex_arg && hex_arg[0])
-        snprintf(url, sizeof(url), "GET /cmd?hex=%s%s HTTP/1.0\r\nHost: %s\r\n\r\n", cmd_hex, hex_arg, ip);
-    else
-        snprintf(url, sizeof(url), "GET /cmd?hex=%s HTTP/1.0\r\nHost: %s\r\n\r\n", cmd_hex, ip);
+    return "Unknown";
+}
+
+static int format_request(char* buf, int size, const char* ip, const struct xifi_cmd* c) {
+    return snprintf(buf, size,
+                    "GET /cmd?hex=%s%s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n\r\n",
+                    c->cmd_hex, c->hex_arg ? c->hex_arg : "", ip);
+}
 
+static void set_status(struct send_result* res, enum send_status st) {
+    memset(res, 0, sizeof(*res));
+    res->status = st;
+}
+
+static uint32_t elapsed_us(Uint64 since) {
+    return (uint32_t)((SDL_GetPerformanceCounter() - since) * 1000000 / SDL_GetPerformanceFrequency());
+}
 
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        return false;
+bool send_result_ok(const struct send_result* res) {
+    return res->status == SEND_OK && res->http_status >= 200 && res->http_status < 300;
+}
+
+// Frames: "LL" + opcode + arg, LL = frame payload length in hex chars
+static int format_batch(char* buf, int size, const char* ip, const struct xifi_cmd* cmds, int n) {
+    char body[1024];
+    int blen = 0;
+    for (int i = 0; i < n; i++) {
+        const char* arg = cmds[i].hex_arg ? cmds[i].hex_arg : "";
+        int flen = (int)(strlen(cmds[i].cmd_hex) + strlen(arg));
+        if (flen > 0xFF) return -1;
+        int w = snprintf(body + blen, sizeof(body) - blen, "%02X%s%s", flen, cmds[i].cmd_hex, arg);
+        if (w < 0 || w >= (int)sizeof(body) - blen) return -1;
+        blen += w;
     }
+    int w = snprintf(buf, size,
+                     "POST /batch HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n"
+                     "Content-Type: text/plain\r\nContent-Length: %d\r\n\r\n%s",
+                     ip, blen, body);
+    return (w < 0 || w >= size) ? -1 : w;
+}
 
+// --- Non-blocking command connection: a state machine driven by the
+// network reactor's select() loop (see cmd_queue.c) ---
+
+void cmd_conn_init(struct cmd_conn* c) {
+    memset(c, 0, sizeof(*c));
+    c->sock = -1;
+    c->caps_batch = -1;
+}
+
+void cmd_conn_close(struct cmd_conn* c) {
+    if (c->sock >= 0) closesocket(c->sock);
+    c->sock = -1;
+}
+
+// Fail every outstanding command of the job and drop the connection
+void cmd_conn_abort(struct cmd_conn* c, enum send_status st) {
+    if (c->phase != CONN_IDLE) {
+        for (int i = c->next; i < c->n; i++) set_status(&c->res[i], st);
+    }
+    cmd_conn_close(c);
+    c->phase = CONN_IDLE;
+}
+
+// Queue the request for the rest of the job: one POST /batch if the device
+// supports it, otherwise every command from c->next on, pipelined
+static void conn_format(struct cmd_conn* c) {
+    c->req_off = 0;
+    c->batch = c->next == 0 && c->n > 1 && c->caps_batch == 1;
+    c->req_len = c->batch ? format_batch(c->req, sizeof(c->req), c->ip, c->cmds, c->n) : -1;
+    if (c->req_len < 0) {
+        c->batch = 0;
+        c->req_len = 0;
+        for (int i = c->next; i < c->n; i++) {
+            int w = format_request(c->req + c->req_len, (int)sizeof(c->req) - c->req_len,
+                                   c->ip, &c->cmds[i]);
+            if (w < 0 || w >= (int)sizeof(c->req) - c->req_len) break;
+            c->req_len += w;
+        }
+    }
+    c->pos = c->len = 0;
+    c->plen = 0;
+    http_resp_init(&c->hr);
+}
+
+// Send the pending request on the kept-alive socket, or connect first
+static void conn_go(struct cmd_conn* c) {
+    conn_format(c);
+    if (c->sock >= 0) {
+        c->phase = CONN_SENDING;
+        c->send_at = SDL_GetPerformanceCounter();
+        return;
+    }
+    c->sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (c->sock < 0) {
+        cmd_conn_abort(c, SEND_ERR_SOCKET);
+        return;
+    }
+    int on = 1;
+    ioctlsocket(c->sock, FIONBIO, &on);
     struct sockaddr_in addr = {0};
     addr.sin_family = AF_INET;
     addr.sin_port = htons(XIFI_CMD_PORT);
-    addr.sin_addr.s_addr = inet_addr(ip);
+    addr.sin_addr.s_addr = inet_addr(c->ip);
+    c->conn_at = SDL_GetPerformanceCounter();
+    if (connect(c->sock, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+        net_stats_record(NS_CONNECT, elapsed_us(c->conn_at));
+        c->phase = CONN_SENDING;
+        c->send_at = SDL_GetPerformanceCounter();
+    } else {
+        c->phase = CONN_CONNECTING;
+    }
+}
+
+bool cmd_conn_begin(struct cmd_conn* c, const char* ip, const struct xifi_cmd* cmds, int n,
+                    struct send_result* res) {
+    if (c->phase != CONN_IDLE || !ip || !cmds || n <= 0) return false;
+    if (strcmp(c->ip, ip) != 0) {
+        cmd_conn_close(c);
+        snprintf(c->ip, sizeof(c->ip), "%s", ip);
+        c->caps_batch = -1;
+    }
+    c->cmds = cmds;
+    c->n = n;
+    c->res = res;
+    c->next = 0;
+    for (int i = 0; i < n; i++) set_status(&res[i], cmds[i].cmd_hex ? SEND_OK : SEND_ERR_ARGS);
+    for (int i = 0; i < n; i++) {
+        if (!cmds[i].cmd_hex) {
+            c->phase = CONN_IDLE;
+            return true;
+        }
+    }
+    c->phase = CONN_CONNECTING;   // placeholder until conn_go picks the real phase
+    conn_go(c);
+    return true;
+}
+
+int cmd_conn_fd(const struct cmd_conn* c, int* want_read, int* want_write) {
+    *want_read = *want_write = 0;
+    if (c->sock < 0) return -1;
+    if (c->phase == CONN_CONNECTING || c->phase == CONN_SENDING) *want_write = 1;
+    else *want_read = 1;   // responses, or EOF on an idle kept-alive socket
+    return c->sock;
+}
+
+// The response to the current command (or the whole batch) is complete
+static void conn_complete(struct cmd_conn* c, int keep) {
+    if (c->hr.xifi_batch) c->caps_batch = 1;
+    if (c->batch && (c->hr.status == 404 || c->hr.status == 405 || c->hr.status == 501)) {
+        // Firmware dropped batch support: remember that and pipeline instead
+        c->caps_batch = 0;
+        if (!keep) cmd_conn_close(c);
+        conn_go(c);
+        return;
+    }
 
-    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
-        closesocket(sock);
-        return false;
+    struct send_result* r = &c->res[c->next];
+    r->payload[c->plen] = 0;
+    r->status = SEND_OK;
+    r->http_status = c->hr.status;
+    r->latency_us = elapsed_us(c->sent_at);
+    if (c->batch) {
+        for (int i = 1; i < c->n; i++) c->res[i] = *r;
+        c->next = c->n;
+    } else {
+        c->next++;
+    }
+
+    if (!keep) cmd_conn_close(c);
+    if (c->next == c->n) {
+        c->phase = CONN_IDLE;   // a kept-alive socket stays open for the next job
+    } else if (!keep) {
+        // Device closes after each response: the rest go on a new connection
+        conn_go(c);
+    } else {
+        http_resp_init(&c->hr);
+        c->plen = 0;
+    }
+}
+
+// Feed received bytes through the parser; completes responses in order
+static void conn_parse(struct cmd_conn* c) {
+    while (c->pos < c->len && c->phase == CONN_READING) {
+        c->pos += (int)http_resp_feed(&c->hr, c->buf + c->pos, c->len - c->pos);
+        if (c->hr.state == HTTP_ERROR) {
+            cmd_conn_abort(c, SEND_ERR_RECV);
+            return;
+        }
+        struct send_result* r = &c->res[c->next];
+        if (c->hr.body_len && c->plen < sizeof(r->payload) - 1) {
+            size_t k = sizeof(r->payload) - 1 - c->plen;
+            if (k > c->hr.body_len) k = c->hr.body_len;
+            memcpy(r->payload + c->plen, c->hr.body, k);
+            c->plen += k;
+        }
+        if (c->hr.state == HTTP_DONE) conn_complete(c, c->hr.keep_alive);
+    }
+}
+
+void cmd_conn_io(struct cmd_conn* c, int readable, int writable) {
+    if (c->sock < 0) return;
+    if (c->phase == CONN_IDLE) {
+        // Idle kept-alive socket became readable: EOF/RST (or stray bytes)
+        if (readable) cmd_conn_close(c);
+        return;
+    }
+    if (c->phase == CONN_CONNECTING && writable) {
+        int err = 0;
+        socklen_t errlen = sizeof(err);
+        if (getsockopt(c->sock, SOL_SOCKET, SO_ERROR, &err, &errlen) != 0 || err != 0) {
+            cmd_conn_abort(c, SEND_ERR_CONNECT);
+            return;
+        }
+        net_stats_record(NS_CONNECT, elapsed_us(c->conn_at));
+        c->phase = CONN_SENDING;
+        c->send_at = SDL_GetPerformanceCounter();
+    }
+    if (c->phase == CONN_SENDING && writable) {
+        int sent = send(c->sock, c->req + c->req_off, c->req_len - c->req_off, 0);
+        if (sent <= 0) {
+            cmd_conn_abort(c, SEND_ERR_SEND);
+            return;
+        }
+        c->req_off += sent;
+        if (c->req_off == c->req_len) {
+            c->phase = CONN_READING;
+            c->sent_at = SDL_GetPerformanceCounter();
+            net_stats_record(NS_SEND, elapsed_us(c->send_at));
+        }
+    } else if (c->phase == CONN_READING && readable) {
+        int got = recv(c->sock, c->buf, sizeof(c->buf), 0);
+        if (got < 0) {
+            cmd_conn_abort(c, SEND_ERR_RECV);
+            return;
+        }
+        if (got == 0) {
+            // Body that runs until EOF, or the device hung up early
+            http_resp_eof(&c->hr);
+            if (c->hr.state == HTTP_DONE) conn_complete(c, 0);
+            else cmd_conn_abort(c, SEND_ERR_RECV);
+            return;
+        }
+        c->pos = 0;
+        c->len = got;
+        conn_parse(c);
     }
-    int sent = send(sock, url, strlen(url), 0);
-    closesocket(sock);
-    return (sent == (int)strlen(url));
 }
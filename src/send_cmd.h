@@ -2,13 +2,100 @@
 #define SEND_CMD_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "http_resp.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Send HTTP command to XiFi device. hex_arg may be NULL.
-bool send_cmd(const char* ip, const char* cmd_hex, const char* hex_arg);
+// Outcome of a single command
+enum send_status {
+    SEND_OK = 0,
+    SEND_ERR_ARGS,      // missing ip/command
+    SEND_ERR_SOCKET,    // could not create a socket
+    SEND_ERR_CONNECT,   // connection refused or failed
+    SEND_ERR_TIMEOUT,   // connect or send did not finish in time
+    SEND_ERR_SEND,      // connection dropped while sending
+    SEND_ERR_RECV,      // no complete response from the device
+    SEND_ERR_OFFLINE,   // heartbeat says the device is gone; not attempted
+};
+
+// Full outcome of one command
+struct send_result {
+    enum send_status status;   // transport outcome
+    int http_status;           // status code from the device, 0 if none
+    uint32_t latency_us;       // request written -> response complete
+    char payload[64];          // start of the device's response body
+};
+
+// One command: opcode plus optional hex argument (may be NULL)
+struct xifi_cmd {
+    const char* cmd_hex;
+    const char* hex_arg;
+};
+
+// Delivered and accepted by the device (2xx)
+bool send_result_ok(const struct send_result* res);
+
+// Most devices one command job addresses
+#define SEND_FANOUT_MAX 8
+
+// --- Non-blocking command connection ---
+// Driven by an event loop from its own select() (the network reactor): add
+// cmd_conn_fd() to the fd sets, pass the readiness to cmd_conn_io(), and a
+// job is finished once phase is back to CONN_IDLE. Commands go out
+// pipelined on a kept-alive HTTP/1.1 socket that stays open between jobs
+// (watch it for EOF while idle). Once the device has advertised batch
+// support ("X-XiFi-Batch: 1" on any reply) a job of several commands goes
+// out as one POST /batch whose body is a sequence of frames: two hex digits
+// giving the frame length in hex characters, then opcode + argument.
+
+#define SEND_RESP_BUF 1024
+
+enum cmd_conn_phase { CONN_IDLE, CONN_CONNECTING, CONN_SENDING, CONN_READING };
+
+struct cmd_conn {
+    int sock;                  // -1 when closed
+    enum cmd_conn_phase phase;
+    char ip[32];
+    int caps_batch;            // -1 unknown, 0 no, 1 yes
+    const struct xifi_cmd* cmds;   // current job; must outlive it
+    int n;
+    struct send_result* res;
+    int next;                  // command whose response is being read
+    int batch;                 // current request is one POST /batch
+    char req[2048];
+    int req_len, req_off;
+    char buf[SEND_RESP_BUF];
+    int pos, len;
+    struct http_resp hr;
+    size_t plen;
+    uint64_t conn_at;          // performance counter: connect started
+    uint64_t send_at;          //   request write started
+    uint64_t sent_at;          //   request fully written
+};
+
+void cmd_conn_init(struct cmd_conn* c);
+
+// Start a job of n commands on ip (reusing an idle kept-alive socket to the
+// same device). res[i] receives each outcome. False if a job is running.
+bool cmd_conn_begin(struct cmd_conn* c, const char* ip, const struct xifi_cmd* cmds, int n,
+                    struct send_result* res);
+
+// Socket to wait on and for what; -1 if nothing is open
+int cmd_conn_fd(const struct cmd_conn* c, int* want_read, int* want_write);
+
+// Make progress after select() reported the socket ready
+void cmd_conn_io(struct cmd_conn* c, int readable, int writable);
+
+// Fail the rest of the job with st (e.g. SEND_ERR_TIMEOUT) and close
+void cmd_conn_abort(struct cmd_conn* c, enum send_status st);
+
+void cmd_conn_close(struct cmd_conn* c);
+
+// Short human readable text for a status code
+const char* send_status_str(enum send_status st);
 
 // Convert ASCII string (up to 32 chars) to uppercase hex string.
 void ascii_to_hex(const char* ascii, char* hexbuf, int hexbufsize);
@@ -0,0 +1,59 @@
+#ifndef SPSC_H
+#define SPSC_H
+
+#include <SDL.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Lock-free single-producer/single-consumer ring of fixed-size items. The
+// producer only writes head, the consumer only writes tail; an item is
+// copied in before head is published and copied out before tail moves, so
+// neither side ever waits on the other. cap must be a power of two.
+struct spsc_ring {
+    SDL_atomic_t head;     // next slot to fill (producer)
+    SDL_atomic_t tail;     // next slot to drain (consumer)
+    unsigned cap;
+    size_t size;
+    unsigned char* items;
+};
+
+static inline void spsc_init(struct spsc_ring* r, void* items, unsigned cap, size_t size) {
+    SDL_AtomicSet(&r->head, 0);
+    SDL_AtomicSet(&r->tail, 0);
+    r->cap = cap;
+    r->size = size;
+    r->items = (unsigned char*)items;
+}
+
+// Producer side. Returns 0 if the ring is full.
+static inline int spsc_push(struct spsc_ring* r, const void* item) {
+    unsigned head = (unsigned)SDL_AtomicGet(&r->head);
+    unsigned tail = (unsigned)SDL_AtomicGet(&r->tail);
+    if (head - tail == r->cap) return 0;
+    SDL_MemoryBarrierAcquire();   // the consumer is done with this slot
+    memcpy(r->items + (head & (r->cap - 1)) * r->size, item, r->size);
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&r->head, (int)(head + 1));
+    return 1;
+}
+
+// Consumer side. Returns 0 if the ring is empty.
+static inline int spsc_pop(struct spsc_ring* r, void* item) {
+    unsigned tail = (unsigned)SDL_AtomicGet(&r->tail);
+    unsigned head = (unsigned)SDL_AtomicGet(&r->head);
+    if (head == tail) return 0;
+    SDL_MemoryBarrierAcquire();   // see the item written before head moved
+    memcpy(item, r->items + (tail & (r->cap - 1)) * r->size, r->size);
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&r->tail, (int)(tail + 1));
+    return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPSC_H
@@ -0,0 +1,78 @@
+// timer_wheel.c - hashed timer wheel for the network reactor
+#include "timer_wheel.h"
+#include <stddef.h>
+
+static void unlink_timer(struct timer_wheel* w, struct tw_timer* t) {
+    if (t->prev) t->prev->next = t->next;
+    else w->slot[(t->due / TW_TICK_MS) % TW_SLOTS] = t->next;
+    if (t->next) t->next->prev = t->prev;
+    t->next = t->prev = NULL;
+    t->armed = 0;
+    w->count--;
+}
+
+void tw_init(struct timer_wheel* w, uint32_t now) {
+    for (int i = 0; i < TW_SLOTS; i++) w->slot[i] = NULL;
+    w->tick = now / TW_TICK_MS;
+    w->count = 0;
+    w->epoch = 0;
+}
+
+void tw_arm(struct timer_wheel* w, struct tw_timer* t, uint32_t now, uint32_t delay_ms,
+            tw_fn fn, void* arg) {
+    if (t->armed) unlink_timer(w, t);
+    t->due = now + delay_ms;
+    // Never file a timer behind the cursor, or it would wait a full lap
+    if ((int32_t)(t->due / TW_TICK_MS - w->tick) < 0) t->due = w->tick * TW_TICK_MS;
+    t->fn = fn;
+    t->arg = arg;
+    struct tw_timer** head = &w->slot[(t->due / TW_TICK_MS) % TW_SLOTS];
+    t->prev = NULL;
+    t->next = *head;
+    if (*head) (*head)->prev = t;
+    *head = t;
+    t->armed = 1;
+    t->epoch = w->epoch;
+    w->count++;
+}
+
+void tw_cancel(struct timer_wheel* w, struct tw_timer* t) {
+    if (t->armed) unlink_timer(w, t);
+}
+
+void tw_run(struct timer_wheel* w, uint32_t now) {
+    uint32_t target = now / TW_TICK_MS;
+    uint32_t epoch = ++w->epoch;
+    // Visit each bucket at most once per call even after a long stall
+    uint32_t steps = target - w->tick + 1;
+    if (steps > TW_SLOTS) steps = TW_SLOTS;
+    for (uint32_t s = 0; s < steps; s++) {
+        uint32_t idx = (target - (steps - 1) + s) % TW_SLOTS;
+        struct tw_timer* t = w->slot[idx];
+        while (t) {
+            struct tw_timer* next = t->next;
+            if ((int32_t)(now - t->due) >= 0 && t->epoch != epoch) {
+                unlink_timer(w, t);
+                t->fn(t->arg);
+                // The callback may have re-armed or cancelled anything in
+                // this bucket: restart it
+                next = w->slot[idx];
+            }
+            t = next;
+        }
+    }
+    w->tick = target;
+}
+
+uint32_t tw_next(const struct timer_wheel* w, uint32_t now) {
+    if (w->count == 0) return UINT32_MAX;
+    uint32_t best = UINT32_MAX;
+    for (int i = 0; i < TW_SLOTS; i++) {
+        for (const struct tw_timer* t = w->slot[i]; t; t = t->next) {
+            int32_t left = (int32_t)(t->due - now);
+            uint32_t l = left < 0 ? 0 : (uint32_t)left;
+            if (l < best) best = l;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,56 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Hashed timer wheel: TW_SLOTS buckets of TW_TICK_MS each; a timer lives in
+// the bucket of its due tick, so arming and cancelling are O(1) and firing
+// only walks the buckets that have come due. Not thread safe: the owning
+// thread (the network reactor) does everything.
+#define TW_TICK_MS 10
+#define TW_SLOTS   64
+
+typedef void (*tw_fn)(void* arg);
+
+struct tw_timer {
+    struct tw_timer* next;
+    struct tw_timer* prev;
+    uint32_t due;          // SDL_GetTicks() value
+    tw_fn fn;
+    void* arg;
+    int armed;
+    uint32_t epoch;        // wheel epoch when armed
+};
+
+struct timer_wheel {
+    struct tw_timer* slot[TW_SLOTS];
+    uint32_t tick;         // last tick processed
+    int count;             // armed timers
+    uint32_t epoch;        // bumped by every tw_run()
+};
+
+void tw_init(struct timer_wheel* w, uint32_t now);
+
+// (Re)arm t to call fn(arg) once at now + delay_ms
+void tw_arm(struct timer_wheel* w, struct tw_timer* t, uint32_t now, uint32_t delay_ms,
+            tw_fn fn, void* arg);
+
+void tw_cancel(struct timer_wheel* w, struct tw_timer* t);
+
+// Fire every timer due by now. Callbacks may arm or cancel timers; one
+// armed from a callback fires on a later run at the earliest.
+void tw_run(struct timer_wheel* w, uint32_t now);
+
+// Milliseconds until the earliest timer is due (0 if overdue), or
+// UINT32_MAX if none is armed
+uint32_t tw_next(const struct timer_wheel* w, uint32_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIMER_WHEEL_H
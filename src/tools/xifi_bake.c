@@ -0,0 +1,196 @@
+// xifi_bake.c - bakes the startup asset packs. For every video mode the
+// Xbox build can pick it decodes and scales the images, renders the static
+// text, and writes MEDIA/pack/WxH.pak: header, key index and 16-byte
+// aligned pixel blocks (format in asset_list.h), ARGB8888 except for the
+// background, which is in the mode's framebuffer format. The app reads a
+// pack with one fread and falls back to the media files if it is missing
+// or stale.
+//
+//   xifi-bake [-m WxH]... MEDIA_DIR
+//
+//   -m WxH    bake this mode (repeatable; default 1280x720, 720x480, 640x480,
+//             the modes platform_nxdk.c probes)
+//
+// Re-run after changing anything in MEDIA_DIR/img or MEDIA_DIR/font.
+#include "asset_list.h"
+#include "img_scale.h"
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_ttf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MAX_MODES 8
+#define MAX_FONTS 4
+
+static const char* media = NULL;
+
+static const char* media_path(const char* rel, char* buf, size_t len) {
+    snprintf(buf, len, "%s/%s", media, rel);
+    return buf;
+}
+
+// One TTF_Font per pixel size, opened on first use and closed after each mode
+static struct { int px; TTF_Font* font; } fonts[MAX_FONTS];
+
+static void fonts_close(void) {
+    for (int i = 0; i < MAX_FONTS; i++) {
+        if (fonts[i].font) TTF_CloseFont(fonts[i].font);
+        fonts[i].font = NULL;
+    }
+}
+
+static TTF_Font* font_for(int px) {
+    for (int i = 0; i < MAX_FONTS; i++) {
+        if (fonts[i].font && fonts[i].px == px) return fonts[i].font;
+    }
+    for (int i = 0; i < MAX_FONTS; i++) {
+        if (fonts[i].font) continue;
+        char path[512];
+        fonts[i].font = TTF_OpenFont(media_path(asset_source_path[ASRC_FONT], path, sizeof(path)), px);
+        fonts[i].px = px;
+        return fonts[i].font;
+    }
+    return NULL;
+}
+
+static SDL_Surface* bake_item(const struct asset_item* it, uint32_t screen_format) {
+    char path[512];
+    SDL_Surface* raw = NULL;
+    SDL_Surface* out = NULL;
+    if (it->kind == ASSET_IMAGE) {
+        // The background is drawn 1:1 on the framebuffer: bake it in its format
+        int bg = it->src == asset_source_path[ASRC_BACKGROUND];
+        raw = IMG_Load(media_path(it->src, path, sizeof(path)));
+        if (raw) out = img_scale(raw, it->w, it->h, bg ? screen_format : SDL_PIXELFORMAT_ARGB8888);
+    } else {
+        TTF_Font* font = font_for(it->font_px);
+        raw = font ? TTF_RenderText_Blended(font, it->src, it->col) : NULL;
+        if (raw) out = SDL_ConvertSurfaceFormat(raw, SDL_PIXELFORMAT_ARGB8888, 0);
+    }
+    if (raw) SDL_FreeSurface(raw);
+    return out;
+}
+
+static uint32_t align_up(uint32_t v) {
+    return (v + ASSET_ALIGN - 1) & ~(uint32_t)(ASSET_ALIGN - 1);
+}
+
+static int bake_mode(int w, int h) {
+    struct asset_item items[ASSET_LIST_MAX];
+    SDL_Surface* surf[ASSET_LIST_MAX];
+    struct asset_pack_entry ent[ASSET_LIST_MAX];
+    int n = asset_list(w, h, items, ASSET_LIST_MAX);
+
+    struct asset_pack_header hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memset(ent, 0, sizeof(ent));
+    hdr.magic = ASSET_PACK_MAGIC;
+    hdr.version = ASSET_PACK_VERSION;
+    hdr.width = (uint32_t)w;
+    hdr.height = (uint32_t)h;
+    hdr.list_hash = asset_list_hash(items, n);
+    hdr.screen_format = asset_screen_format(w, h);
+    hdr.count = (uint32_t)n;
+    for (int s = 0; s < ASRC_COUNT; s++) {
+        char path[512];
+        hdr.source_hash[s] = asset_source_hash(media_path(asset_source_path[s], path, sizeof(path)));
+        if (!hdr.source_hash[s]) {
+            fprintf(stderr, "missing %s\n", path);
+            return 1;
+        }
+    }
+
+    uint32_t offset = align_up(sizeof(hdr) + sizeof(ent[0]) * n);
+    for (int i = 0; i < n; i++) {
+        surf[i] = bake_item(&items[i], hdr.screen_format);
+        if (!surf[i]) {
+            fprintf(stderr, "%dx%d: could not bake %s: %s\n", w, h, items[i].key, SDL_GetError());
+            while (i--) SDL_FreeSurface(surf[i]);
+            fonts_close();
+            return 1;
+        }
+        snprintf(ent[i].key, sizeof(ent[i].key), "%s", items[i].key);
+        ent[i].w = (uint32_t)surf[i]->w;
+        ent[i].h = (uint32_t)surf[i]->h;
+        ent[i].pitch = (uint32_t)surf[i]->w * surf[i]->format->BytesPerPixel;
+        ent[i].format = surf[i]->format->format;
+        ent[i].size = ent[i].pitch * ent[i].h;
+        ent[i].offset = offset;
+        offset = align_up(offset + ent[i].size);
+    }
+    hdr.file_size = offset;
+
+    char rel[32], path[512];
+    media_path(asset_pack_name(rel, sizeof(rel), w, h), path, sizeof(path));
+    FILE* f = fopen(path, "wb");
+    int err = !f;
+    if (f) {
+        static const unsigned char zero[ASSET_ALIGN];
+        uint32_t at = sizeof(hdr) + sizeof(ent[0]) * n;
+        err |= fwrite(&hdr, sizeof(hdr), 1, f) != 1;
+        err |= fwrite(ent, sizeof(ent[0]), n, f) != (size_t)n;
+        for (int i = 0; i < n && !err; i++) {
+            err |= fwrite(zero, 1, ent[i].offset - at, f) != ent[i].offset - at;
+            for (uint32_t y = 0; y < ent[i].h; y++) {
+                const unsigned char* row = (const unsigned char*)surf[i]->pixels + y * surf[i]->pitch;
+                err |= fwrite(row, 1, ent[i].pitch, f) != ent[i].pitch;
+            }
+            at = ent[i].offset + ent[i].size;
+        }
+        err |= fwrite(zero, 1, hdr.file_size - at, f) != hdr.file_size - at;
+        err |= fclose(f) != 0;
+    }
+    for (int i = 0; i < n; i++) SDL_FreeSurface(surf[i]);
+    fonts_close();
+    if (err) {
+        fprintf(stderr, "could not write %s\n", path);
+        return 1;
+    }
+    printf("%s: %d assets, %u KB\n", path, n, (unsigned)(hdr.file_size / 1024));
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int modes[MAX_MODES][2], n_modes = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "m:")) != -1) {
+        if (opt == 'm' && n_modes < MAX_MODES &&
+            sscanf(optarg, "%dx%d", &modes[n_modes][0], &modes[n_modes][1]) == 2 &&
+            modes[n_modes][0] > 0 && modes[n_modes][1] > 0) {
+            n_modes++;
+            continue;
+        }
+        fprintf(stderr, "usage: %s [-m WxH]... MEDIA_DIR\n", argv[0]);
+        return 2;
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-m WxH]... MEDIA_DIR\n", argv[0]);
+        return 2;
+    }
+    media = argv[optind];
+    if (!n_modes) {
+        static const int def[3][2] = { {1280, 720}, {720, 480}, {640, 480} };
+        memcpy(modes, def, sizeof(def));
+        n_modes = 3;
+    }
+
+    if (SDL_Init(0) != 0 || TTF_Init() != 0 ||
+        (IMG_Init(IMG_INIT_JPG | IMG_INIT_PNG) & (IMG_INIT_JPG | IMG_INIT_PNG)) != (IMG_INIT_JPG | IMG_INIT_PNG)) {
+        fprintf(stderr, "init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+    char dir[512];
+    mkdir(media_path("pack", dir, sizeof(dir)), 0755);
+
+    int rc = 0;
+    for (int i = 0; i < n_modes && !rc; i++) rc = bake_mode(modes[i][0], modes[i][1]);
+
+    IMG_Quit();
+    TTF_Quit();
+    SDL_Quit();
+    return rc;
+}
@@ -0,0 +1,169 @@
+// xifi_load.c - load generator: drives the app's own detection and command
+// path (xifi_detect, cmd_queue, the network reactor) against a XiFi or
+// xifi-sim and reports discovery time, command RTT and commands/sec.
+//
+//   -n N      commands to send (default 1000)
+//   -w N      jobs in flight (default 1, at most 8)
+//   -b N      commands per job, pipelined or batched (default 1)
+//   -d N      devices per job: the target repeated N times (default 1)
+//   -a IP     target address instead of the detected primary device
+//   -o HEX    opcode to send (default 0101)
+//   -t SEC    give up on discovery after SEC seconds (default 10)
+//   -s FILE   write the app's network stats (histograms) to FILE
+//
+// Example, all on loopback:
+//   build-host/xifi-sim -q -l 2 -j 3 &
+//   build-host/xifi-load -n 5000 -w 4 -b 3
+#include "platform.h"
+#include "xifi_detect.h"
+#include "cmd_queue.h"
+#include "net_reactor.h"
+#include "net_stats.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ID_RING 4096             // push times by command id (power of 2)
+
+static int cmp_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Nearest-rank percentile of a sorted array
+static uint32_t pct(const uint32_t* v, int n, int p) {
+    if (n == 0) return 0;
+    int i = (n * p + 99) / 100 - 1;
+    return v[i < 0 ? 0 : i];
+}
+
+static void report(const char* what, uint32_t* v, int n) {
+    qsort(v, n, sizeof(v[0]), cmp_u32);
+    printf("%-22s p50 %6.2f  p95 %6.2f  p99 %6.2f  max %6.2f ms\n", what,
+           pct(v, n, 50) / 1000.0, pct(v, n, 95) / 1000.0, pct(v, n, 99) / 1000.0,
+           n ? v[n - 1] / 1000.0 : 0.0);
+}
+
+int main(int argc, char** argv) {
+    int total = 1000, window = 1, per_job = 1, devices = 1, discover_s = 10;
+    const char* target = NULL;
+    const char* opcode = "0101";
+    const char* stats_file = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:w:b:d:a:o:t:s:")) != -1) {
+        switch (opt) {
+            case 'n': total = atoi(optarg); break;
+            case 'w': window = atoi(optarg); break;
+            case 'b': per_job = atoi(optarg); break;
+            case 'd': devices = atoi(optarg); break;
+            case 'a': target = optarg; break;
+            case 'o': opcode = optarg; break;
+            case 't': discover_s = atoi(optarg); break;
+            case 's': stats_file = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-n cmds] [-w jobs] [-b per-job] [-d devices] "
+                                "[-a ip] [-o opcode] [-t sec] [-s file]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (total <= 0 || window < 1 || window > 8 || per_job < 1 || per_job > CMD_JOB_MAX ||
+        devices < 1 || devices > SEND_FANOUT_MAX) {
+        fprintf(stderr, "bad arguments\n");
+        return 2;
+    }
+
+    if (SDL_Init(SDL_INIT_TIMER) != 0 || !plat_net_init()) {
+        fprintf(stderr, "init failed\n");
+        return 1;
+    }
+
+    // --- Discovery ---
+    uint32_t t0 = SDL_GetTicks();
+    if (!XiFi_StartDetection(1000) || !CmdQueue_Start()) {
+        fprintf(stderr, "could not start the network reactor\n");
+        return 1;
+    }
+    while (!XiFi_IsPresent()) {
+        if (SDL_GetTicks() - t0 > (uint32_t)discover_s * 1000) {
+            fprintf(stderr, "no XiFi found in %d s (%s)\n", discover_s, XiFi_GetDebug());
+            NetReactor_Stop();
+            return 1;
+        }
+        SDL_Delay(1);
+    }
+    struct xifi_stats st;
+    XiFi_GetStats(&st);
+    printf("discovery: %u ms from start (%u ms first probe to reply), device %s\n",
+           (unsigned)(SDL_GetTicks() - t0), (unsigned)st.time_to_detect_ms, XiFi_GetIP());
+
+    // --- Commands ---
+    char ip[32];
+    snprintf(ip, sizeof(ip), "%s", target ? target : XiFi_GetIP());
+    const char* ips[SEND_FANOUT_MAX];
+    for (int k = 0; k < devices; k++) ips[k] = ip;
+    struct xifi_cmd cmds[CMD_JOB_MAX];
+    for (int i = 0; i < per_job; i++) cmds[i] = (struct xifi_cmd){ opcode, NULL };
+
+    int per_push = devices * per_job;
+    int jobs = (total + per_push - 1) / per_push;
+    int expect = jobs * per_push;
+    uint32_t* rtt = malloc(sizeof(uint32_t) * expect);
+    uint32_t* wire = malloc(sizeof(uint32_t) * expect);
+    static Uint64 pushed_at[ID_RING];
+    if (!rtt || !wire) return 1;
+
+    int pushed = 0, done = 0, ok = 0, in_flight = 0, n_wire = 0;
+    int by_status[SEND_ERR_OFFLINE + 1] = {0};
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    while (done < expect) {
+        while (pushed < jobs && in_flight < window) {
+            int last = CmdQueue_PushFanout(ips, devices, cmds, per_job);
+            if (!last) break;
+            Uint64 now = SDL_GetPerformanceCounter();
+            for (int id = last - per_push + 1; id <= last; id++) pushed_at[id & (ID_RING - 1)] = now;
+            pushed++;
+            in_flight++;
+        }
+        int id;
+        struct send_result res;
+        int got = 0;
+        while (CmdQueue_PollResult(&id, &res)) {
+            Uint64 now = SDL_GetPerformanceCounter();
+            rtt[done] = (uint32_t)((now - pushed_at[id & (ID_RING - 1)]) * 1000000 / freq);
+            if (res.status <= SEND_ERR_OFFLINE) by_status[res.status]++;
+            if (send_result_ok(&res)) {
+                ok++;
+                wire[n_wire++] = res.latency_us;
+            }
+            done++;
+            got = 1;
+            // Results come back job by job; the job's last id closes it
+            if (id % per_push == 0) in_flight--;
+        }
+        if (!got) usleep(50);
+    }
+    double secs = (double)(SDL_GetPerformanceCounter() - start) / freq;
+
+    printf("commands: %d sent, %d ok in %.3f s -> %.0f cmd/s (%d per job, %d device(s), "
+           "%d job(s) in flight)\n", done, ok, secs, done / secs, per_job, devices, window);
+    for (int s = 1; s <= SEND_ERR_OFFLINE; s++) {
+        if (by_status[s]) printf("  %-10s %d\n", send_status_str((enum send_status)s), by_status[s]);
+    }
+    report("push -> result", rtt, done);
+    report("request -> response", wire, n_wire);
+    if (CmdQueue_Dropped()) printf("results dropped: %u\n", (unsigned)CmdQueue_Dropped());
+
+    XiFi_GetStats(&st);
+    printf("heartbeat: srtt %.2f ms, loss %u%%, %u probes, %u replies\n",
+           st.srtt_us / 1000.0, (unsigned)st.loss_pct, (unsigned)st.probes_sent, (unsigned)st.replies);
+
+    NetReactor_Stop();
+    if (stats_file && !net_stats_dump(stats_file)) fprintf(stderr, "could not write %s\n", stats_file);
+    free(rtt);
+    free(wire);
+    SDL_Quit();
+    return ok == done ? 0 : 1;
+}
@@ -0,0 +1,426 @@
+// xifi_sim.c - stand-in XiFi device for testing detection and commands on Linux
+//
+// Answers "XiFi?" on UDP 19784 with "XiFi: PRESENT" and serves
+// GET /cmd?hex=<opcode><arg> (and POST /batch) on TCP 1337, like the
+// firmware. Every decoded opcode and argument is logged. Faults can be
+// injected to see how the app copes:
+//
+//   -l MS     response latency (UDP replies and HTTP responses)
+//   -j MS     uniform jitter added to the latency, 0..MS
+//   -p PCT    drop this share of discovery probes
+//   -r PCT    refuse this share of connections (reset right after accept)
+//   -s BPS    slow reader: read requests at BPS bytes per second
+//   -c        close the connection after every response (no keep-alive)
+//   -n        no batch support (POST /batch answers 404, never advertised)
+//   -b ADDR   bind address (default 0.0.0.0)
+//   -U PORT   UDP port (default 19784)   -T PORT   TCP port (default 1337)
+//   -S SEED   random seed                -q        don't log commands
+//
+// Counters are printed on SIGINT/SIGTERM.
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <ctype.h>
+#include <stdarg.h>
+
+#define DEFAULT_UDP_PORT 19784
+#define DEFAULT_TCP_PORT 1337
+#define REQ_BUF          8192
+#define SLOW_CHUNK       16       // bytes per read in slow-reader mode
+
+struct sim_config {
+    const char* bind_addr;
+    int udp_port, tcp_port;
+    unsigned latency_ms, jitter_ms;
+    unsigned loss_pct, refuse_pct;
+    unsigned slow_bps;
+    int close_each, no_batch, quiet;
+    unsigned seed;
+};
+
+static struct sim_config cfg = { "0.0.0.0", DEFAULT_UDP_PORT, DEFAULT_TCP_PORT,
+                                 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+static struct {
+    unsigned long probes, replies, probes_dropped;
+    unsigned long conns, refused, requests, cmds, batches, bad;
+} counters;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned rng_state;
+
+// Shared PRNG (xorshift32) behind the counter lock
+static unsigned sim_rand(void) {
+    pthread_mutex_lock(&lock);
+    unsigned x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng_state = x;
+    pthread_mutex_unlock(&lock);
+    return x;
+}
+
+static int chance(unsigned pct) {
+    return pct && sim_rand() % 100 < pct;
+}
+
+#define COUNT(field) do { pthread_mutex_lock(&lock); counters.field++; pthread_mutex_unlock(&lock); } while (0)
+
+static void sleep_ms(unsigned ms) {
+    struct timespec t = { ms / 1000, (long)(ms % 1000) * 1000000 };
+    while (nanosleep(&t, &t) != 0 && errno == EINTR) {}
+}
+
+// Configured latency plus jitter
+static void respond_delay(void) {
+    unsigned ms = cfg.latency_ms;
+    if (cfg.jitter_ms) ms += sim_rand() % (cfg.jitter_ms + 1);
+    if (ms) sleep_ms(ms);
+}
+
+static void log_line(const char* peer, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void log_line(const char* peer, const char* fmt, ...) {
+    if (cfg.quiet) return;
+    char text[512];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    struct tm tm;
+    localtime_r(&ts.tv_sec, &tm);
+    printf("%02d:%02d:%02d.%03ld %-21s %s\n", tm.tm_hour, tm.tm_min, tm.tm_sec,
+           ts.tv_nsec / 1000000, peer, text);
+    fflush(stdout);
+}
+
+static int is_hex(const char* s, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (!isxdigit((unsigned char)s[i])) return 0;
+    }
+    return 1;
+}
+
+// Log one command: 4 hex digits of opcode, the rest is the argument (shown
+// decoded as ASCII too, as the status text commands carry)
+static void log_cmd(const char* peer, const char* hex, size_t n, const char* via) {
+    char op[5] = {0}, arg[260] = {0}, ascii[130] = {0};
+    memcpy(op, hex, n < 4 ? n : 4);
+    if (n > 4) {
+        size_t alen = n - 4 < sizeof(arg) - 1 ? n - 4 : sizeof(arg) - 1;
+        memcpy(arg, hex + 4, alen);
+        for (size_t i = 0; i + 1 < alen && i / 2 < sizeof(ascii) - 1; i += 2) {
+            unsigned v;
+            sscanf(arg + i, "%2x", &v);
+            ascii[i / 2] = isprint((int)v) ? (char)v : '.';
+        }
+    }
+    COUNT(cmds);
+    if (arg[0]) log_line(peer, "%s opcode %s arg %s \"%s\"", via, op, arg, ascii);
+    else log_line(peer, "%s opcode %s", via, op);
+}
+
+// --- UDP discovery ---
+
+static void* UdpThread(void* param) {
+    int sock = *(int*)param;
+    for (;;) {
+        char buf[128];
+        struct sockaddr_in from;
+        socklen_t len = sizeof(from);
+        int got = recvfrom(sock, buf, sizeof(buf) - 1, 0, (struct sockaddr*)&from, &len);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            perror("recvfrom");
+            return NULL;
+        }
+        buf[got] = 0;
+        if (strcmp(buf, "XiFi?") != 0) continue;
+        COUNT(probes);
+        if (chance(cfg.loss_pct)) {
+            COUNT(probes_dropped);
+            continue;
+        }
+        respond_delay();
+        const char* msg = "XiFi: PRESENT";
+        if (sendto(sock, msg, strlen(msg), 0, (struct sockaddr*)&from, len) > 0) COUNT(replies);
+    }
+}
+
+// --- HTTP commands ---
+
+struct conn {
+    int sock;
+    char peer[32];
+};
+
+static int send_all(int sock, const char* buf, size_t len) {
+    while (len) {
+        ssize_t w = send(sock, buf, len, MSG_NOSIGNAL);
+        if (w <= 0) return -1;
+        buf += w;
+        len -= (size_t)w;
+    }
+    return 0;
+}
+
+static int respond(int sock, int status, const char* reason, const char* body, int keep) {
+    char out[512];
+    int n = snprintf(out, sizeof(out),
+                     "HTTP/1.1 %d %s\r\nContent-Length: %zu\r\n%s%s\r\n%s",
+                     status, reason, strlen(body),
+                     cfg.no_batch ? "" : "X-XiFi-Batch: 1\r\n",
+                     keep ? "" : "Connection: close\r\n", body);
+    return send_all(sock, out, (size_t)n);
+}
+
+// Header value by name (case-insensitive) within the request head, or NULL
+static const char* header(const char* head, const char* name, char* val, size_t len) {
+    size_t nlen = strlen(name);
+    for (const char* p = strstr(head, "\r\n"); p; p = strstr(p, "\r\n")) {
+        p += 2;
+        if (strncasecmp(p, name, nlen) == 0 && p[nlen] == ':') {
+            p += nlen + 1;
+            while (*p == ' ') p++;
+            size_t n = strcspn(p, "\r\n");
+            if (n >= len) n = len - 1;
+            memcpy(val, p, n);
+            val[n] = 0;
+            return val;
+        }
+    }
+    return NULL;
+}
+
+// Serve one complete request; returns 0 to keep the connection
+static int serve(struct conn* c, const char* head, const char* body, size_t blen) {
+    char method[8] = {0}, target[1024] = {0}, val[32];
+    COUNT(requests);
+    int keep = !cfg.close_each;
+    if (header(head, "Connection", val, sizeof(val)) && strcasecmp(val, "close") == 0) keep = 0;
+    if (sscanf(head, "%7s %1023s", method, target) != 2) {
+        COUNT(bad);
+        respond(c->sock, 400, "Bad Request", "bad request", 0);
+        return -1;
+    }
+
+    int status = 200;
+    const char* reason = "OK";
+    const char* reply = "OK";
+    if (strcmp(method, "GET") == 0 && strncmp(target, "/cmd?hex=", 9) == 0) {
+        const char* hex = target + 9;
+        size_t n = strcspn(hex, "&");
+        if (n < 4 || n % 2 || !is_hex(hex, n)) {
+            status = 400, reason = "Bad Request", reply = "bad hex";
+            COUNT(bad);
+            log_line(c->peer, "rejected %s", target);
+        } else {
+            log_cmd(c->peer, hex, n, "GET  ");
+        }
+    } else if (strcmp(method, "POST") == 0 && strcmp(target, "/batch") == 0 && !cfg.no_batch) {
+        // Frames: two hex digits of length, then that many hex chars
+        size_t off = 0;
+        int frames = 0;
+        while (off + 2 <= blen) {
+            unsigned flen;
+            if (!is_hex(body + off, 2) || sscanf(body + off, "%2x", &flen) != 1 ||
+                off + 2 + flen > blen || flen < 4 || !is_hex(body + off + 2, flen)) {
+                status = 400, reason = "Bad Request", reply = "bad frame";
+                break;
+            }
+            log_cmd(c->peer, body + off + 2, flen, "BATCH");
+            off += 2 + flen;
+            frames++;
+        }
+        if (status == 200 && off != blen) status = 400, reason = "Bad Request", reply = "bad frame";
+        if (status == 200) COUNT(batches);
+        else COUNT(bad);
+        log_line(c->peer, "batch of %d frame(s) -> %d", frames, status);
+    } else {
+        status = 404, reason = "Not Found", reply = "not found";
+        log_line(c->peer, "%s %s -> 404", method, target);
+    }
+
+    respond_delay();
+    if (respond(c->sock, status, reason, reply, keep) != 0) return -1;
+    return keep ? 0 : -1;
+}
+
+// Read into buf: everything available, or SLOW_CHUNK bytes paced to slow_bps
+static ssize_t read_some(int sock, char* buf, size_t room) {
+    if (cfg.slow_bps) {
+        if (room > SLOW_CHUNK) room = SLOW_CHUNK;
+        sleep_ms((unsigned)(room * 1000 / cfg.slow_bps));
+    }
+    return recv(sock, buf, room, 0);
+}
+
+static void* ConnThread(void* param) {
+    struct conn* c = param;
+    char buf[REQ_BUF + 1];
+    size_t have = 0;
+    for (;;) {
+        // Complete requests already buffered (pipelining)
+        buf[have] = 0;
+        char* end = strstr(buf, "\r\n\r\n");
+        if (end) {
+            size_t head_len = (size_t)(end - buf) + 4;
+            char val[16];
+            *end = 0;
+            long clen = header(buf, "Content-Length", val, sizeof(val)) ? atol(val) : 0;
+            *end = '\r';
+            if (clen < 0 || head_len + (size_t)clen > REQ_BUF) break;
+            if (have >= head_len + (size_t)clen) {
+                *end = 0;
+                int r = serve(c, buf, buf + head_len, (size_t)clen);
+                size_t used = head_len + (size_t)clen;
+                memmove(buf, buf + used, have - used);
+                have -= used;
+                if (r != 0) break;
+                continue;
+            }
+        }
+        if (have == REQ_BUF) break;
+        ssize_t got = read_some(c->sock, buf + have, REQ_BUF - have);
+        if (got <= 0) break;
+        have += (size_t)got;
+    }
+    close(c->sock);
+    free(c);
+    return NULL;
+}
+
+static void* TcpThread(void* param) {
+    int lsock = *(int*)param;
+    for (;;) {
+        struct sockaddr_in from;
+        socklen_t len = sizeof(from);
+        int s = accept(lsock, (struct sockaddr*)&from, &len);
+        if (s < 0) {
+            if (errno == EINTR) continue;
+            perror("accept");
+            return NULL;
+        }
+        COUNT(conns);
+        char peer[32];
+        snprintf(peer, sizeof(peer), "%s:%u", inet_ntoa(from.sin_addr), ntohs(from.sin_port));
+        if (chance(cfg.refuse_pct)) {
+            // Abortive close: the client sees a reset, as from a busy device
+            struct linger lg = { 1, 0 };
+            setsockopt(s, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+            close(s);
+            COUNT(refused);
+            log_line(peer, "connection refused (reset)");
+            continue;
+        }
+        int one = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        struct conn* c = malloc(sizeof(*c));
+        if (!c) {
+            close(s);
+            continue;
+        }
+        c->sock = s;
+        snprintf(c->peer, sizeof(c->peer), "%s", peer);
+        pthread_t t;
+        if (pthread_create(&t, NULL, ConnThread, c) != 0) {
+            close(s);
+            free(c);
+            continue;
+        }
+        pthread_detach(t);
+    }
+}
+
+static int open_socket(int type, int port) {
+    int s = socket(AF_INET, type, 0);
+    if (s < 0) return -1;
+    int one = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = inet_addr(cfg.bind_addr);
+    if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        (type == SOCK_STREAM && listen(s, 64) != 0)) {
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [-l ms] [-j ms] [-p loss%%] [-r refuse%%] [-s bytes/s] [-c] [-n]\n"
+            "          [-b addr] [-U port] [-T port] [-S seed] [-q]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    cfg.seed = (unsigned)time(NULL);
+    int opt;
+    while ((opt = getopt(argc, argv, "l:j:p:r:s:cnb:U:T:S:q")) != -1) {
+        switch (opt) {
+            case 'l': cfg.latency_ms = (unsigned)atoi(optarg); break;
+            case 'j': cfg.jitter_ms = (unsigned)atoi(optarg); break;
+            case 'p': cfg.loss_pct = (unsigned)atoi(optarg); break;
+            case 'r': cfg.refuse_pct = (unsigned)atoi(optarg); break;
+            case 's': cfg.slow_bps = (unsigned)atoi(optarg); break;
+            case 'c': cfg.close_each = 1; break;
+            case 'n': cfg.no_batch = 1; break;
+            case 'b': cfg.bind_addr = optarg; break;
+            case 'U': cfg.udp_port = atoi(optarg); break;
+            case 'T': cfg.tcp_port = atoi(optarg); break;
+            case 'S': cfg.seed = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'q': cfg.quiet = 1; break;
+            default: usage(argv[0]);
+        }
+    }
+    rng_state = cfg.seed ? cfg.seed : 1;
+
+    int usock = open_socket(SOCK_DGRAM, cfg.udp_port);
+    int tsock = open_socket(SOCK_STREAM, cfg.tcp_port);
+    if (usock < 0 || tsock < 0) {
+        fprintf(stderr, "cannot bind %s UDP %d / TCP %d: %s\n",
+                cfg.bind_addr, cfg.udp_port, cfg.tcp_port, strerror(errno));
+        return 1;
+    }
+
+    // Counters are printed from main once a signal arrives
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+
+    pthread_t ut, tt;
+    pthread_create(&ut, NULL, UdpThread, &usock);
+    pthread_create(&tt, NULL, TcpThread, &tsock);
+    fprintf(stderr, "xifi-sim on %s: UDP %d, TCP %d (latency %u+%u ms, loss %u%%, refuse %u%%, "
+                    "slow %u B/s, %s, batch %s, seed %u)\n",
+            cfg.bind_addr, cfg.udp_port, cfg.tcp_port, cfg.latency_ms, cfg.jitter_ms,
+            cfg.loss_pct, cfg.refuse_pct, cfg.slow_bps, cfg.close_each ? "close" : "keep-alive",
+            cfg.no_batch ? "off" : "on", cfg.seed);
+
+    int sig;
+    sigwait(&sigs, &sig);
+    pthread_mutex_lock(&lock);
+    fprintf(stderr, "\nprobes %lu (dropped %lu, answered %lu)\n"
+                    "connections %lu (refused %lu), requests %lu, commands %lu, batches %lu, bad %lu\n",
+            counters.probes, counters.probes_dropped, counters.replies, counters.conns,
+            counters.refused, counters.requests, counters.cmds, counters.batches, counters.bad);
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
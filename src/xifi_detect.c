@@ -1,131 +1,692 @@
 // xifi_detect.c
 #include "xifi_detect.h"
+#include "platform.h"
+#include "net_reactor.h"
+#include "net_stats.h"
 #include <SDL.h>
-#include <lwip/sockets.h>
-#include <lwip/inet.h>
-#include <lwip/netif.h>
-#include <lwip/dhcp.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdarg.h>
 
 #define XIFI_PORT 19784
 #define BROADCAST_IP "255.255.255.255"
-#define DETECTION_INTERVAL_MS 2000
+#define DETECTION_INTERVAL_MS 2000   // default heartbeat period once found
+#define REPLY_TIMEOUT_MS 200
+#define DEFAULT_MISS_LIMIT 3
 
-static volatile int detected = 0;
-static volatile int detection_running = 0;
-static char xifi_ip[32] = "Unavailable";
-static char detect_debug[128] = "Not started";
+// Discovery schedule: a tight burst, then exponential backoff up to the
+// heartbeat period. Each round goes to the limited and the subnet-directed
+// broadcast, and also unicasts the last address that answered.
+#define BURST_PROBES 4
+#define BURST_GAP_MS 50
+#define BACKOFF_START_MS 250
+#define IP_CACHE_FILE "xifi_last_ip.txt"
 
-static int WaitForIP(void) {
-    struct netif* nif = netif_default;
-    if (!nif) {
-        snprintf(xifi_ip, sizeof(xifi_ip), "No NIC");
-        return 0;
-    }
-    if (!ip_addr_isany_val(nif->ip_addr)) {
-        snprintf(xifi_ip, sizeof(xifi_ip), "%s", ipaddr_ntoa(&nif->ip_addr));
-        return 1;
+// Device table upkeep once something has been found
+#define BROADCAST_EVERY 5        // heartbeats between broadcasts for newcomers
+#define DEVICE_EXPIRE_BEATS 30   // silent this long: drop from the table
+
+// Unicast sweep of the subnet, for networks that drop broadcast: first when
+// the burst goes unanswered, then every SWEEP_EVERY backoff rounds
+#define SWEEP_EVERY 8
+#define SWEEP_WINDOW 64          // probes awaiting a reply at once
+#define SWEEP_RATE 500           // probes per second
+#define SWEEP_MAX_HOSTS 1022     // larger subnets: sweep our own /22 only
+
+#define NET_POLL_MS 100          // interface state check, if the platform can't notify
+#define NET_RETRY_MS 1000        // offline with notifications: retry SessionOpen
+
+// Session phases; one timer (phase_timer) drives whichever is current
+enum {
+    PHASE_OFFLINE,               // no link/address, no socket
+    PHASE_DISCOVER,              // discovery round out, waiting for any reply
+    PHASE_SWEEP,                 // unicast subnet sweep in progress
+    PHASE_BEAT,                  // heartbeat out, collecting replies
+    PHASE_IDLE                   // between heartbeats
+};
+
+// Published state, written only by the network reactor under a seqlock:
+// seq is odd while an update is in progress.
+static SDL_atomic_t state_seq;
+static struct xifi_state state;
+static struct xifi_device pub_devs[XIFI_MAX_DEVICES];
+static int pub_dev_count = 0;
+static char debug_text[128] = "Not started";
+
+// Reactor-thread private working copies
+static uint32_t device_ip = 0;      // primary device, network byte order
+static uint32_t cached_ip = 0;      // last address that answered, from IP_CACHE_FILE
+static int detected = 0;
+static struct plat_net_state net;   // interface state as of the last plat_net_wait
+
+// Current session on the network reactor
+static int sock = -1;
+static int phase = PHASE_OFFLINE;
+static unsigned attempt = 0, beat_no = 0;
+static uint32_t discover_start = 0, beat_start = 0;
+static Uint64 round_t0 = 0;         // this round's broadcast, for RTT
+static int beat_bcast = 0;
+static int reported = 0;
+static struct tw_timer phase_timer, net_poll_timer;
+static SDL_atomic_t net_changed;    // set by the platform's notify thread
+static int net_notified = 0;        // plat_net_notify works: no fast polling
+
+// Subnet sweep progress (PHASE_SWEEP)
+static struct {
+    uint32_t first, last, next, self;   // host byte order
+    uint32_t probes, start;
+    int inflight, found;
+    struct { uint32_t ip; uint32_t sent_ms; Uint64 t0; } slot[SWEEP_WINDOW];
+} sw;
+
+// Every device that has answered, deduplicated by source address
+struct dev_entry {
+    struct xifi_device d;
+    uint32_t misses;        // consecutive unanswered heartbeats
+    Uint64 probe_t0;        // this beat's unicast probe, 0 = not probed
+    int answered;
+};
+static struct dev_entry devs[XIFI_MAX_DEVICES];
+static int dev_count = 0;
+
+static volatile unsigned hb_interval_ms = DETECTION_INTERVAL_MS;
+static volatile unsigned hb_miss_limit = DEFAULT_MISS_LIMIT;
+
+static struct xifi_stats stats;
+static SDL_SpinLock stats_lock = 0;
+static uint32_t beat_history = 0;   // bit set = beat went unanswered
+static uint32_t beats = 0;
+
+static void SeqWriteBegin(void) {
+    SDL_AtomicAdd(&state_seq, 1);
+    SDL_MemoryBarrierRelease();
+}
+
+static void SeqWriteEnd(void) {
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicAdd(&state_seq, 1);
+}
+
+// Publish present/ip/last-seen and the device table; the generation only
+// moves when presence, the primary address or the device set changes
+static void PublishState(int present, uint32_t ip, uint32_t last_seen) {
+    int changed = state.present != present || state.ipv4 != ip || pub_dev_count != dev_count;
+    for (int i = 0; i < dev_count && !changed; i++) {
+        changed = pub_devs[i].ipv4 != devs[i].d.ipv4 || pub_devs[i].present != devs[i].d.present;
     }
-    dhcp_start(nif);
-    uint32_t start = SDL_GetTicks();
-    while (ip_addr_isany_val(nif->ip_addr)) {
-        if ((SDL_GetTicks() - start) > 20000) {
-            snprintf(xifi_ip, sizeof(xifi_ip), "No DHCP");
-            return 0;
+    SeqWriteBegin();
+    if (changed) state.generation++;
+    state.present = present;
+    state.ipv4 = ip;
+    state.last_seen_ms = last_seen;
+    for (int i = 0; i < dev_count; i++) pub_devs[i] = devs[i].d;
+    pub_dev_count = dev_count;
+    SeqWriteEnd();
+}
+
+static void SetDebug(const char* fmt, ...) {
+    char line[sizeof(debug_text)];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    SeqWriteBegin();
+    memcpy(debug_text, line, sizeof(debug_text));
+    SeqWriteEnd();
+}
+
+// The network went away under us: devices are unreachable until rediscovered
+static void MarkAbsent(void) {
+    for (int i = 0; i < dev_count; i++) devs[i].d.present = 0;
+    SDL_AtomicLock(&stats_lock);
+    stats.present = 0;
+    detected = 0;
+    uint32_t last_seen = stats.last_seen_ms;
+    SDL_AtomicUnlock(&stats_lock);
+    PublishState(0, device_ip, last_seen);
+}
+
+static uint32_t ticks_to_us(Uint64 t) {
+    return (uint32_t)(t * 1000000 / SDL_GetPerformanceFrequency());
+}
+
+static uint32_t popcount32(uint32_t v) {
+    uint32_t n = 0;
+    for (; v; v &= v - 1) n++;
+    return n;
+}
+
+// Record the outcome of one heartbeat; rtt_us is ignored when !answered
+static void RecordBeat(int answered, uint32_t rtt_us) {
+    SDL_AtomicLock(&stats_lock);
+    beat_history = (beat_history << 1) | (answered ? 0 : 1);
+    if (beats < 32) beats++;
+    uint32_t mask = beats < 32 ? ((1u << beats) - 1) : 0xFFFFFFFFu;
+    stats.loss_pct = popcount32(beat_history & mask) * 100 / beats;
+
+    if (answered) {
+        stats.replies++;
+        stats.missed_in_row = 0;
+        stats.last_seen_ms = SDL_GetTicks();
+        stats.last_rtt_us = rtt_us;
+        if (stats.srtt_us == 0) {
+            stats.srtt_us = rtt_us;
+            stats.rttvar_us = rtt_us / 2;
+        } else {
+            int32_t err = (int32_t)rtt_us - (int32_t)stats.srtt_us;
+            uint32_t aerr = err < 0 ? (uint32_t)-err : (uint32_t)err;
+            stats.rttvar_us += ((int32_t)aerr - (int32_t)stats.rttvar_us) / 4;
+            stats.srtt_us += err / 8;
         }
-        SDL_Delay(100);
+        stats.present = 1;
+    } else {
+        stats.missed_in_row++;
+        if (stats.missed_in_row >= hb_miss_limit) stats.present = 0;
     }
-    snprintf(xifi_ip, sizeof(xifi_ip), "%s", ipaddr_ntoa(&nif->ip_addr));
-    return 1;
+    detected = stats.present;
+    uint32_t last_seen = stats.last_seen_ms;
+    SDL_AtomicUnlock(&stats_lock);
+
+    PublishState(detected, device_ip, last_seen);
 }
 
-static int DetectThread(void* param) {
-    if (!WaitForIP()) {
-        detected = 0;
-        detection_running = 0;
-        snprintf(detect_debug, sizeof(detect_debug), "No IP");
-        return 1;
+// Record a reply from ip in the device table. RTT runs from the device's own
+// unicast probe if it had one this round, else from round_t0 (the round's
+// broadcast, or the sweep probe that found it).
+static void NoteReply(uint32_t ip, Uint64 round_t0) {
+    struct dev_entry* e = NULL;
+    for (int i = 0; i < dev_count; i++) {
+        if (devs[i].d.ipv4 == ip) e = &devs[i];
+    }
+    if (!e) {
+        if (dev_count == XIFI_MAX_DEVICES) return;
+        e = &devs[dev_count++];
+        memset(e, 0, sizeof(*e));
+        e->d.ipv4 = ip;
     }
+    uint32_t rtt = ticks_to_us(SDL_GetPerformanceCounter() - (e->probe_t0 ? e->probe_t0 : round_t0));
+    e->d.last_rtt_us = rtt;
+    net_stats_record(NS_PROBE_RTT, rtt);
+    e->d.srtt_us = e->d.srtt_us ? e->d.srtt_us + ((int32_t)rtt - (int32_t)e->d.srtt_us) / 8 : rtt;
+    e->d.last_seen_ms = SDL_GetTicks();
+    e->d.present = 1;
+    e->misses = 0;
+    e->answered = 1;
+}
 
-    int sock = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sock < 0) {
-        snprintf(detect_debug, sizeof(detect_debug), "Sock fail: %d", sock);
-        detection_running = 0;
-        return 1;
+static int AllProbedAnswered(void) {
+    for (int i = 0; i < dev_count; i++) {
+        if (devs[i].probe_t0 && !devs[i].answered) return 0;
     }
+    return 1;
+}
 
-    // Enable broadcast
-    int yes = 1;
-    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &yes, sizeof(yes));
+static uint32_t LoadCachedIP(void) {
+    char path[256], line[32] = {0};
+    FILE* f = fopen(plat_data_path(IP_CACHE_FILE, path, sizeof(path)), "r");
+    if (!f) return 0;
+    int ok = fscanf(f, "%31s", line) == 1;
+    fclose(f);
+    uint32_t ip = ok ? inet_addr(line) : INADDR_NONE;
+    return ip == INADDR_NONE ? 0 : ip;
+}
 
+static void SaveCachedIP(uint32_t ip) {
+    char path[256], text[32];
+    FILE* f = fopen(plat_data_path(IP_CACHE_FILE, path, sizeof(path)), "w");
+    if (!f) return;   // read-only media: run without a cache
+    fprintf(f, "%s\n", XiFi_FormatIP(ip, text, sizeof(text)));
+    fclose(f);
+}
+
+// Wait before discovery probe n (0-based) is followed by the next one
+static uint32_t DiscoveryGap(unsigned n) {
+    if (n < BURST_PROBES) return BURST_GAP_MS;
+    unsigned shift = n - BURST_PROBES;
+    uint32_t gap = BACKOFF_START_MS << (shift > 8 ? 8 : shift);
+    return gap < hb_interval_ms ? gap : hb_interval_ms;
+}
+
+static int SendProbe(int sock, uint32_t ip) {
     struct sockaddr_in addr = {0};
     addr.sin_family = AF_INET;
     addr.sin_port = htons(XIFI_PORT);
-    addr.sin_addr.s_addr = inet_addr(BROADCAST_IP);
+    addr.sin_addr.s_addr = ip;
+    const char* msg = "XiFi?";
+    int sent = sendto(sock, msg, strlen(msg), 0, (struct sockaddr*)&addr, sizeof(addr));
+    SDL_AtomicLock(&stats_lock);
+    stats.probes_sent++;
+    SDL_AtomicUnlock(&stats_lock);
+    net_stats_count(NS_PROBES_SENT);
+    return sent;
+}
 
-    struct sockaddr_in from = {0};
-    socklen_t fromlen = sizeof(from);
+// Close out a heartbeat: age silent devices, drop long-gone ones and keep
+// the primary on a live device (a new one if DHCP moved or it left).
+// Returns 1 if any device answered, with the primary's RTT (or the first
+// responder's) in *rtt_us.
+static int EndBeat(uint32_t* rtt_us) {
+    int n = 0;
+    for (int i = 0; i < dev_count; i++) {
+        struct dev_entry* e = &devs[i];
+        if (e->probe_t0 && !e->answered) {
+            e->misses++;
+            if (e->misses >= hb_miss_limit) e->d.present = 0;
+        }
+        if (e->misses < DEVICE_EXPIRE_BEATS) devs[n++] = *e;
+    }
+    dev_count = n;
 
-    detected = 0;
-    snprintf(detect_debug, sizeof(detect_debug), "Started");
-
-    while (detection_running) {
-        // Send discovery packet
-        const char* msg = "XiFi?";
-        int sent = sendto(sock, msg, strlen(msg), 0, (struct sockaddr*)&addr, sizeof(addr));
-        snprintf(detect_debug, sizeof(detect_debug), "Discovery sent: %d", sent);
-
-        // Wait for reply (non-blocking, 200ms timeout)
-        struct timeval tv = {0, 200 * 1000};
-        fd_set readset;
-        FD_ZERO(&readset);
-        FD_SET(sock, &readset);
-        int r = select(sock + 1, &readset, NULL, NULL, &tv);
-
-        if (r > 0 && FD_ISSET(sock, &readset)) {
-            char buf[64];
-            int got = recvfrom(sock, buf, sizeof(buf) - 1, 0, (struct sockaddr*)&from, &fromlen);
-            if (got > 0) {
-                buf[got] = 0;
-                if (strstr(buf, "XiFi: PRESENT")) {
-                    snprintf(xifi_ip, sizeof(xifi_ip), "%s", inet_ntoa(from.sin_addr));
-                    detected = 1;
-                    snprintf(detect_debug, sizeof(detect_debug), "REPLY: %s [%s]", buf, xifi_ip);
-                    break;
-                } else {
-                    snprintf(detect_debug, sizeof(detect_debug), "Reply ignored: %s", buf);
-                }
-            } else {
-                snprintf(detect_debug, sizeof(detect_debug), "Recv fail: %d", got);
+    struct dev_entry* primary = NULL;
+    for (int i = 0; i < dev_count; i++) {
+        if (devs[i].d.ipv4 == device_ip && devs[i].d.present) primary = &devs[i];
+    }
+    for (int i = 0; i < dev_count && !primary; i++) {
+        if (devs[i].d.present) primary = &devs[i];
+    }
+    if (primary) device_ip = primary->d.ipv4;
+
+    for (int i = 0; i < dev_count; i++) {
+        if (!devs[i].answered) continue;
+        *rtt_us = primary && primary->answered ? primary->d.last_rtt_us : devs[i].d.last_rtt_us;
+        return 1;
+    }
+    *rtt_us = 0;
+    return 0;
+}
+
+// Unicast to every known device (plus the cached address); returns how
+// many probes went out
+static int ProbeKnown(int sock, int timed) {
+    int n = 0, cached_known = 0;
+    for (int i = 0; i < dev_count; i++) {
+        devs[i].answered = 0;
+        devs[i].probe_t0 = timed ? SDL_GetPerformanceCounter() : 0;
+        SendProbe(sock, devs[i].d.ipv4);
+        cached_known |= devs[i].d.ipv4 == cached_ip;
+        n++;
+    }
+    if (!timed && cached_ip && !cached_known) {
+        SendProbe(sock, cached_ip);
+        n++;
+    }
+    return n;
+}
+
+// Read one datagram. Returns 0 once the socket is drained, else 1 with
+// *from set to the source of a XiFi reply (0 for anything else).
+static int RecvReply(int s, uint32_t* from) {
+    struct sockaddr_in addr = {0};
+    socklen_t len = sizeof(addr);
+    char buf[64];
+    int got = recvfrom(s, buf, sizeof(buf) - 1, 0, (struct sockaddr*)&addr, &len);
+    if (got <= 0) return 0;
+    buf[got] = 0;
+    *from = 0;
+    if (strstr(buf, "XiFi: PRESENT")) {
+        *from = addr.sin_addr.s_addr;
+        net_stats_count(NS_PROBE_REPLIES);
+        SetDebug("REPLY: %s [%s]", buf, inet_ntoa(addr.sin_addr));
+    } else {
+        SetDebug("Reply ignored: %s", buf);
+    }
+    return 1;
+}
+
+static void DiscoveryRound(void* arg);
+static void Heartbeat(void* arg);
+
+// A discovery round or the sweep got an answer: switch to heartbeats
+static void Found(void) {
+    uint32_t rtt;
+    int answered = EndBeat(&rtt);   // sets rtt: not in the same call's arguments
+    RecordBeat(answered, rtt);
+    beat_no = 0;   // first heartbeat broadcasts to collect the rest
+    uint32_t took = SDL_GetTicks() - discover_start;
+    char ip[32];
+    plat_log("XiFi found at %s in %u ms (%u probe rounds%s)\n",
+             XiFi_FormatIP(device_ip, ip, sizeof(ip)), (unsigned)took, attempt,
+             device_ip == cached_ip ? ", cached address" : "");
+    SDL_AtomicLock(&stats_lock);
+    stats.time_to_detect_ms = took;
+    SDL_AtomicUnlock(&stats_lock);
+    net_stats_count(NS_DETECTIONS);
+    net_stats_record(NS_DETECT, took * 1000);
+    if (device_ip != cached_ip) {
+        cached_ip = device_ip;
+        SaveCachedIP(device_ip);
+    }
+    phase = PHASE_IDLE;
+    net_timer(&phase_timer, hb_interval_ms, Heartbeat, NULL);
+}
+
+static void StartDiscovery(void) {
+    attempt = 0;
+    discover_start = SDL_GetTicks();
+    DiscoveryRound(NULL);
+}
+
+// Close the sweep: heartbeats if it found anything, else back to backoff
+static void SweepEnd(void) {
+    uint32_t took = SDL_GetTicks() - sw.start;
+    plat_log("Subnet sweep: %u probes, %d replies in %u ms\n", sw.probes, sw.found, (unsigned)took);
+    SetDebug("Sweep: %u probes, %d found, %u ms", sw.probes, sw.found, (unsigned)took);
+    SDL_AtomicLock(&stats_lock);
+    stats.sweep_ms = took;
+    stats.sweep_probes = sw.probes;
+    SDL_AtomicUnlock(&stats_lock);
+    if (sw.found) Found();
+    else DiscoveryRound(NULL);
+}
+
+// Sweep pacing: retire expired probes, send as many as SWEEP_RATE and the
+// window allow, then sleep until the next send slot or expiry (a reply that
+// frees a slot calls in early)
+static void SweepStep(void* arg) {
+    uint32_t now = SDL_GetTicks();
+    for (int i = 0; i < sw.inflight; ) {
+        if (now - sw.slot[i].sent_ms >= REPLY_TIMEOUT_MS) sw.slot[i] = sw.slot[--sw.inflight];
+        else i++;
+    }
+    uint32_t allowed = (now - sw.start) * SWEEP_RATE / 1000 + 1;
+    while (sw.inflight < SWEEP_WINDOW && sw.next <= sw.last && sw.probes < allowed) {
+        uint32_t host = sw.next++;
+        if (host == sw.self) continue;
+        sw.slot[sw.inflight].ip = htonl(host);
+        sw.slot[sw.inflight].sent_ms = now;
+        sw.slot[sw.inflight].t0 = SDL_GetPerformanceCounter();
+        SendProbe(sock, sw.slot[sw.inflight].ip);
+        sw.inflight++;
+        sw.probes++;
+    }
+    if (sw.next > sw.last && sw.inflight == 0) {
+        SweepEnd();
+        return;
+    }
+
+    uint32_t wait = REPLY_TIMEOUT_MS;
+    for (int i = 0; i < sw.inflight; i++) {
+        uint32_t left = REPLY_TIMEOUT_MS - (now - sw.slot[i].sent_ms);
+        if (left < wait) wait = left;
+    }
+    if (sw.next <= sw.last && sw.inflight < SWEEP_WINDOW) {
+        uint32_t due = sw.start + sw.probes * 1000 / SWEEP_RATE;
+        uint32_t gap = (int32_t)(due - now) > 0 ? due - now : 0;
+        if (gap < wait) wait = gap;
+    }
+    net_timer(&phase_timer, wait, SweepStep, NULL);
+}
+
+// Unicast-probe every host of the local subnet, paced to SWEEP_RATE with at
+// most SWEEP_WINDOW unanswered probes (a probe's slot frees on its reply or
+// after REPLY_TIMEOUT_MS)
+static void SweepBegin(void) {
+    uint32_t ip = ntohl(net.ipv4), mask = ntohl(net.netmask);
+    // /31 and /32 have no network/broadcast pair to step inside: no sweep
+    if (!mask || mask > 0xFFFFFFFCu) {
+        DiscoveryRound(NULL);
+        return;
+    }
+    sw.first = (ip & mask) + 1;
+    sw.last = (ip | ~mask) - 1;
+    if (sw.last - sw.first + 1 > SWEEP_MAX_HOSTS) {
+        uint32_t m22 = 0xFFFFFC00u;
+        sw.first = (ip & m22) + 1;
+        sw.last = (ip | ~m22) - 1;
+    }
+    sw.self = ip;
+    sw.next = sw.first;
+    sw.probes = 0;
+    sw.inflight = sw.found = 0;
+    sw.start = SDL_GetTicks();
+    phase = PHASE_SWEEP;
+    net_stats_count(NS_SWEEPS);
+    SweepStep(NULL);
+}
+
+// A discovery round went unanswered: sweep if it is due, else the next round
+static void RoundTimeout(void* arg) {
+    unsigned round = attempt - 1;
+    if (round >= BURST_PROBES && (round - BURST_PROBES) % SWEEP_EVERY == 0) {
+        // Broadcast may be filtered here: ask every host directly
+        SweepBegin();
+        return;
+    }
+    SetDebug("No reply (round %u)", attempt);
+    DiscoveryRound(NULL);
+}
+
+// Limited and subnet-directed broadcast plus unicasts to the cached address
+// and any devices still in the table. A late answer to an earlier round
+// still counts.
+static void DiscoveryRound(void* arg) {
+    round_t0 = SDL_GetPerformanceCounter();
+    int sent = SendProbe(sock, inet_addr(BROADCAST_IP));
+    if (net.netmask && net.netmask != 0xFFFFFFFFu)
+        SendProbe(sock, net.ipv4 | ~net.netmask);
+    ProbeKnown(sock, 0);
+    SetDebug("Discovery sent: %d", sent);
+    phase = PHASE_DISCOVER;
+    net_timer(&phase_timer, DiscoveryGap(attempt++), RoundTimeout, NULL);
+}
+
+// Close out a heartbeat (REPLY_TIMEOUT_MS passed, or every probed device
+// answered a unicast-only beat)
+static void BeatEnd(void* arg) {
+    net_timer_cancel(&phase_timer);
+    uint32_t rtt;
+    int answered = EndBeat(&rtt);
+    if (!answered) SetDebug("No reply");
+    RecordBeat(answered, rtt);
+    if (!detected) {
+        // Lost it: start over with a fresh burst
+        net_stats_count(NS_LOSSES);
+        StartDiscovery();
+        return;
+    }
+    uint32_t spent = SDL_GetTicks() - beat_start;
+    phase = PHASE_IDLE;
+    net_timer(&phase_timer, spent < hb_interval_ms ? hb_interval_ms - spent : 0, Heartbeat, NULL);
+}
+
+// Unicast heartbeat to every known device; every few beats also broadcast
+// so consoles added later join the table
+static void Heartbeat(void* arg) {
+    beat_start = SDL_GetTicks();
+    round_t0 = SDL_GetPerformanceCounter();
+    beat_bcast = beat_no++ % BROADCAST_EVERY == 0;
+    if (beat_bcast) SendProbe(sock, inet_addr(BROADCAST_IP));
+    ProbeKnown(sock, 1);
+    phase = PHASE_BEAT;
+    net_timer(&phase_timer, REPLY_TIMEOUT_MS, BeatEnd, NULL);
+}
+
+// Discovery socket readable (reactor callback)
+static void OnReadable(void* arg, int readable, int writable) {
+    uint32_t from;
+    int got = 0, freed = 0;
+    while (sock >= 0 && RecvReply(sock, &from)) {
+        if (!from) continue;
+        if (phase == PHASE_DISCOVER) {
+            NoteReply(from, round_t0);
+            Found();
+        } else if (phase == PHASE_SWEEP) {
+            Uint64 t0 = SDL_GetPerformanceCounter();
+            for (int i = 0; i < sw.inflight; i++) {
+                if (sw.slot[i].ip != from) continue;
+                t0 = sw.slot[i].t0;
+                sw.slot[i] = sw.slot[--sw.inflight];
+                freed = 1;
+                break;
             }
-        } else {
-            snprintf(detect_debug, sizeof(detect_debug), "No reply (r=%d)", r);
+            NoteReply(from, t0);
+            sw.found++;
+        } else if (phase == PHASE_BEAT) {
+            NoteReply(from, round_t0);
+            got = 1;
         }
+        // PHASE_IDLE: a straggler from an earlier beat would skew the RTT
+    }
+    if (phase == PHASE_SWEEP && freed) SweepStep(NULL);
+    else if (phase == PHASE_BEAT && got && !beat_bcast && AllProbedAnswered()) BeatEnd(NULL);
+}
 
-        SDL_Delay(DETECTION_INTERVAL_MS);
+static void SessionClose(void) {
+    net_timer_cancel(&phase_timer);
+    if (sock >= 0) {
+        net_unwatch(sock);
+        closesocket(sock);
+        sock = -1;
     }
+    phase = PHASE_OFFLINE;
+    if (detected) MarkAbsent();
+}
 
-    closesocket(sock);
-    detection_running = 0;
-    return 0;
+// Link and address are up: open the discovery socket and start searching
+static void SessionOpen(void) {
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        SetDebug("Sock fail: %d", sock);
+        return;   // retried on the next network poll
+    }
+
+    // Enable broadcast; the reactor only reads once select() says so
+    int yes = 1;
+    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &yes, sizeof(yes));
+    ioctlsocket(sock, FIONBIO, &yes);
+    if (!net_watch(sock, 1, 0, OnReadable, NULL)) {
+        SetDebug("Watch table full");
+        closesocket(sock);
+        sock = -1;
+        return;
+    }
+
+    if (!reported) {
+        // SDL_GetTicks() counts from SDL_Init, i.e. close to boot
+        uint32_t now = SDL_GetTicks();
+        char ip[32];
+        plat_log("Network up (%s, %s); first probe %u ms after boot\n",
+                 net.source, XiFi_FormatIP(net.ipv4, ip, sizeof(ip)), (unsigned)now);
+        SDL_AtomicLock(&stats_lock);
+        stats.boot_to_probe_ms = now;
+        SDL_AtomicUnlock(&stats_lock);
+        reported = 1;
+    }
+    StartDiscovery();
 }
 
-void XiFi_StartDetectionThread(unsigned interval_ms) {
-    if (detection_running) return;
-    detection_running = 1;
-    detected = 0;
-    SDL_CreateThread(DetectThread, "XiFiDetect", NULL);
+// Follow the interface: a link or address change ends the session, and a
+// usable address starts a new one
+static void NetPoll(void* arg) {
+    if (plat_net_wait(net.seq, 0, &net)) SessionClose();
+    if (phase == PHASE_OFFLINE) {
+        if (net.link_up && net.ipv4) SessionOpen();
+        else SetDebug(net.link_up ? "Waiting for IP (%s)" : "No link (%s)", net.source);
+    }
+    // With notifications, only a failed SessionOpen needs another look
+    if (!net_notified) net_timer(&net_poll_timer, NET_POLL_MS, NetPoll, NULL);
+    else if (phase == PHASE_OFFLINE) net_timer(&net_poll_timer, NET_RETRY_MS, NetPoll, NULL);
+    else net_timer_cancel(&net_poll_timer);
+}
+
+// Platform thread: the interface moved, have the reactor look
+static void NetChanged(void) {
+    SDL_AtomicSet(&net_changed, 1);
+    NetReactor_Wake();
+}
+
+void XiFi_ReactorBegin(void) {
+    cached_ip = LoadCachedIP();
+    SetDebug("Started");
+    SDL_AtomicSet(&net_changed, 0);
+    net_notified = plat_net_notify(NetChanged);
+    NetPoll(NULL);
+}
+
+void XiFi_ReactorPoll(void) {
+    if (SDL_AtomicCAS(&net_changed, 1, 0)) NetPoll(NULL);
+}
+
+void XiFi_ReactorEnd(void) {
+    plat_net_notify(NULL);
+    net_notified = 0;
+    net_timer_cancel(&net_poll_timer);
+    SessionClose();
+}
+
+bool XiFi_StartDetection(unsigned interval_ms) {
+    if (interval_ms) hb_interval_ms = interval_ms;
+    return NetReactor_Start();
+}
+
+void XiFi_SetHeartbeat(unsigned interval_ms, unsigned miss_limit) {
+    if (interval_ms) hb_interval_ms = interval_ms;
+    if (miss_limit) hb_miss_limit = miss_limit;
+}
+
+// Seqlock readers: a retry means the reactor is mid-update, so yield to it
+// (SDL_Delay(0)) rather than spin against it on a single core
+
+int XiFi_GetDevices(struct xifi_device* out, int max) {
+    int n;
+    for (;; SDL_Delay(0)) {
+        int s1 = SDL_AtomicGet(&state_seq);
+        SDL_MemoryBarrierAcquire();
+        if (s1 & 1) continue;
+        n = pub_dev_count < max ? pub_dev_count : max;
+        for (int i = 0; i < n; i++) out[i] = pub_devs[i];
+        SDL_MemoryBarrierAcquire();
+        if (SDL_AtomicGet(&state_seq) == s1) return n;
+    }
+}
+
+void XiFi_GetState(struct xifi_state* out) {
+    for (;; SDL_Delay(0)) {
+        int s1 = SDL_AtomicGet(&state_seq);
+        SDL_MemoryBarrierAcquire();
+        if (s1 & 1) continue;   // writer mid-update
+        *out = state;
+        SDL_MemoryBarrierAcquire();
+        if (SDL_AtomicGet(&state_seq) == s1) return;
+    }
+}
+
+const char* XiFi_FormatIP(uint32_t ipv4, char* buf, int buflen) {
+    const uint8_t* b = (const uint8_t*)&ipv4;   // network order: first octet first
+    snprintf(buf, buflen, "%u.%u.%u.%u", b[0], b[1], b[2], b[3]);
+    return buf;
 }
 
 int XiFi_IsPresent(void) {
-    return detected;
+    struct xifi_state s;
+    XiFi_GetState(&s);
+    return s.present;
 }
 
 const char* XiFi_GetIP(void) {
-    return xifi_ip;
+    static char ip[32];
+    struct xifi_state s;
+    XiFi_GetState(&s);
+    if (!s.ipv4) return "Unavailable";
+    return XiFi_FormatIP(s.ipv4, ip, sizeof(ip));
 }
 
 const char* XiFi_GetDebug(void) {
-    return detect_debug;
+    static char text[sizeof(debug_text)];
+    for (;; SDL_Delay(0)) {
+        int s1 = SDL_AtomicGet(&state_seq);
+        SDL_MemoryBarrierAcquire();
+        if (s1 & 1) continue;
+        memcpy(text, debug_text, sizeof(text));
+        SDL_MemoryBarrierAcquire();
+        if (SDL_AtomicGet(&state_seq) == s1) break;
+    }
+    text[sizeof(text) - 1] = 0;
+    return text;
+}
+
+void XiFi_GetStats(struct xifi_stats* out) {
+    SDL_AtomicLock(&stats_lock);
+    *out = stats;
+    SDL_AtomicUnlock(&stats_lock);
 }
@@ -1,22 +1,91 @@
 #ifndef XIFI_DETECT_H
 #define XIFI_DETECT_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Start the detection thread (poll every interval_ms milliseconds)
-void XiFi_StartDetectionThread(unsigned interval_ms);
+// Liveness and link quality of the XiFi, as seen by the heartbeat
+struct xifi_stats {
+    int present;              // 1 while the device answers heartbeats
+    uint32_t last_seen_ms;    // SDL_GetTicks() of the last reply, 0 = never
+    uint32_t last_rtt_us;     // most recent round trip
+    uint32_t srtt_us;         // smoothed RTT (1/8 gain, as TCP)
+    uint32_t rttvar_us;       // smoothed mean deviation (1/4 gain)
+    uint32_t probes_sent;
+    uint32_t replies;
+    uint32_t missed_in_row;   // consecutive unanswered heartbeats
+    uint32_t loss_pct;        // unanswered share of the last 32 heartbeats
+    uint32_t time_to_detect_ms; // first discovery probe to first reply, latest search
+    uint32_t boot_to_probe_ms;  // SDL_Init to the first probe (network readiness)
+    uint32_t sweep_ms;          // duration of the last unicast subnet sweep
+    uint32_t sweep_probes;      // probes it sent
+};
+
+// Consistent snapshot of the detection state
+struct xifi_state {
+    int present;              // 1 while any device answers heartbeats
+    uint32_t ipv4;            // primary device, network byte order (0 = none yet)
+    uint32_t generation;      // bumped whenever present or ipv4 changes
+    uint32_t last_seen_ms;    // SDL_GetTicks() of the last reply, 0 = never
+};
+
+// Every XiFi that answers discovery is tracked, up to this many
+#define XIFI_MAX_DEVICES 8
+
+// One entry of the device table
+struct xifi_device {
+    uint32_t ipv4;            // network byte order; unique within the table
+    int present;              // answered within the heartbeat miss limit
+    uint32_t last_seen_ms;
+    uint32_t last_rtt_us;
+    uint32_t srtt_us;         // smoothed RTT (1/8 gain)
+};
+
+// Start detection on the network reactor (heartbeat every interval_ms
+// milliseconds once found). Starts the reactor if it isn't running; returns
+// false if it can't be started.
+bool XiFi_StartDetection(unsigned interval_ms);
+
+// Heartbeat period and how many missed beats mark the device absent
+void XiFi_SetHeartbeat(unsigned interval_ms, unsigned miss_limit);
 
 // Returns 1 if detected, 0 if not detected
 int XiFi_IsPresent(void);
 
-// Returns the last detected IP as a string, or "Unavailable"
+// Lock-free, tear-free copy of the detection state (seqlock read side).
+// Compare generation with the previous snapshot to skip work when nothing
+// changed.
+void XiFi_GetState(struct xifi_state* out);
+
+// Copy up to max entries of the device table (same seqlock as the state;
+// its generation also moves when devices come, go or change presence).
+// Returns the number copied.
+int XiFi_GetDevices(struct xifi_device* out, int max);
+
+// Format a state's ipv4 as dotted quad into buf; returns buf
+const char* XiFi_FormatIP(uint32_t ipv4, char* buf, int buflen);
+
+// Returns the last detected IP as a string, or "Unavailable". The string
+// is copied from a snapshot into a buffer owned by the calling (UI) thread;
+// other threads should use XiFi_GetState().
 const char* XiFi_GetIP(void);
 
-// Returns a debug string for on-screen diagnostics
+// Returns a debug string for on-screen diagnostics (same rules as XiFi_GetIP)
 const char* XiFi_GetDebug(void);
 
+// Copy the current heartbeat statistics
+void XiFi_GetStats(struct xifi_stats* out);
+
+// Called by the network reactor on its own thread when it starts and stops,
+// and once per loop in between to pick up interface changes
+void XiFi_ReactorBegin(void);
+void XiFi_ReactorPoll(void);
+void XiFi_ReactorEnd(void);
+
 #ifdef __cplusplus
 }
 #endif